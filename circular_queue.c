@@ -5,6 +5,11 @@
  *
  * revision history:
  *  v1.0 Creation (14/01/2024)
+ *  v1.1 capacity per queue (power of 2), index masking (16/10/2026)
+ *  v1.2 span routines (a block of bytes at once) (16/10/2026)
+ *  v1.3 pokeQueue (16/10/2026)
+ *  v1.4 getQueueSpan withdrawn, the LN driver transmits the LN message from
+ *       its record in the LN TX queue (v2.16 of ln.c) (16/10/2026)
  */
 
 #include "circular_queue.h"
@@ -12,10 +17,14 @@
 /**
  * initialise the queue
  * @param queue: name of the queue (pass the address of the queue)
+ * @param values: the buffer of the queue
+ * @param size: the capacity of the buffer (power of 2, max. QUEUE_SIZE)
  */
-void initQueue(lnQueue_t* queue)
+void initQueue(lnQueue_t* queue, uint8_t* values, uint8_t size)
 {
-    queue->size = QUEUE_SIZE;
+    queue->values = values;
+    queue->size = size;
+    queue->mask = size - 1;
     queue->head = 0;
     queue->tail = 0;
     queue->numEntries = 0;
@@ -60,7 +69,7 @@ bool enQueue(lnQueue_t* queue, uint8_t value)
         // put the value to the queue and return true
         queue->values[queue->tail] = value;
         queue->numEntries++;
-        queue->tail = (queue->tail + 1) % queue->size;
+        queue->tail = (queue->tail + 1) & queue->mask;
         return isQueueFull(queue);
     }
 }
@@ -81,7 +90,7 @@ bool deQueue(lnQueue_t* queue)
     else
     {
         // set the values and return true
-        queue->head = (queue->head + 1) % queue->size;
+        queue->head = (queue->head + 1) & queue->mask;
         queue->numEntries--;
         return isQueueEmpty(queue);
     }
@@ -93,8 +102,84 @@ bool deQueue(lnQueue_t* queue)
  */
 void clearQueue(lnQueue_t* lnQueue)
 {
-    while (!isQueueEmpty(lnQueue))
+    lnQueue->head = 0;
+    lnQueue->tail = 0;
+    lnQueue->numEntries = 0;
+}
+
+/**
+ * get the free space of the queue
+ * @param queue: name of the queue (pass the address of the queue)
+ * @return the number of values that can be put on the queue
+ */
+uint8_t getQueueFree(lnQueue_t* queue)
+{
+    return (queue->size - queue->numEntries);
+}
+
+/**
+ * get a value from the queue without removing it
+ * @param queue: name of the queue (pass the address of the queue)
+ * @param offset: the position of the value (0 = head)
+ * @return the value (the offset is not checked against numEntries)
+ */
+uint8_t peekQueue(lnQueue_t* queue, uint8_t offset)
+{
+    return queue->values[(queue->head + offset) & queue->mask];
+}
+
+/**
+ * overwrite a value in the queue
+ * @param queue: name of the queue (pass the address of the queue)
+ * @param offset: the position of the value (0 = head)
+ * @param value: the new value (the offset is not checked against numEntries)
+ */
+void pokeQueue(lnQueue_t* queue, uint8_t offset, uint8_t value)
+{
+    queue->values[(queue->head + offset) & queue->mask] = value;
+}
+
+/**
+ * put a block of values on the queue
+ * @param queue: name of the queue (pass the address of the queue)
+ * @param values: the values to put on the queue
+ * @param length: the number of values
+ * @return true: if all values are put on the queue, false: if there was not
+ * enough space (nothing is put on the queue)
+ */
+bool enQueueSpan(lnQueue_t* queue, uint8_t* values, uint8_t length)
+{
+    // a single check for the whole block
+    if (length > getQueueFree(queue))
+    {
+        return false;
+    }
+    uint8_t tail = queue->tail;
+    for (uint8_t i = 0; i < length; i++)
     {
-        deQueue(lnQueue);
+        queue->values[tail] = values[i];
+        tail = (tail + 1) & queue->mask;
+    }
+    queue->tail = tail;
+    queue->numEntries += length;
+    return true;
+}
+
+/**
+ * remove a block of values from the queue
+ * @param queue: name of the queue (pass the address of the queue)
+ * @param length: the number of values
+ * @return true: if the values are removed, false: if the queue has less
+ * values (nothing is removed)
+ */
+bool deQueueSpan(lnQueue_t* queue, uint8_t length)
+{
+    // a single check for the whole block
+    if (length > queue->numEntries)
+    {
+        return false;
     }
+    queue->head = (queue->head + length) & queue->mask;
+    queue->numEntries -= length;
+    return true;
 }
@@ -5,6 +5,11 @@
  *
  * revision history:
  *  v1.0 Creation (14/01/2024)
+ *  v1.1 capacity per queue (power of 2), index masking (16/10/2026)
+ *  v1.2 span routines (a block of bytes at once) (16/10/2026)
+ *  v1.3 pokeQueue (16/10/2026)
+ *  v1.4 getQueueSpan withdrawn, the LN driver transmits the LN message from
+ *       its record in the LN TX queue (v2.16 of ln.c) (16/10/2026)
  */
 
 #ifndef CIRCULAR_QUEUE_H
@@ -13,22 +18,38 @@
 #include "config.h"
 
 // 128 bytes is the theoretical maximum length of a LN message
+// this is also the maximum capacity of a queue
 #define QUEUE_SIZE 128
 
+// the capacity of every queue is fixed at compile time and must be a power
+// of 2 (so the head and tail index can be masked instead of a modulo)
+// use it in a preprocessor test: #if !IS_QUEUE_SIZE_VALID(size) #error ...
+#define IS_QUEUE_SIZE_VALID(size) \
+    (((size) > 0) && ((size) <= QUEUE_SIZE) && (((size) & ((size) - 1)) == 0))
+
+// the buffer of the queue is a separate array, so every queue has his own
+// capacity (declare the array next to the queue, see initQueue)
+
 typedef struct lnQueue_t {
     uint8_t head;
     uint8_t tail;
     uint8_t numEntries;
     uint8_t size;
-    uint8_t values[QUEUE_SIZE];
+    uint8_t mask;
+    uint8_t* values;
 } lnQueue_t;
 
-void initQueue(lnQueue_t*);
+void initQueue(lnQueue_t*, uint8_t*, uint8_t);
 bool isQueueEmpty(lnQueue_t*);
 bool isQueueFull(lnQueue_t*);
 bool enQueue(lnQueue_t*, uint8_t);
 bool deQueue(lnQueue_t*);
 void clearQueue(lnQueue_t*);
+uint8_t getQueueFree(lnQueue_t*);
+uint8_t peekQueue(lnQueue_t*, uint8_t);
+void pokeQueue(lnQueue_t*, uint8_t, uint8_t);
+bool enQueueSpan(lnQueue_t*, uint8_t*, uint8_t);
+bool deQueueSpan(lnQueue_t*, uint8_t);
 
 #endif	/* CIRCULAR_QUEUE_H */
 
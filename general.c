@@ -5,10 +5,59 @@
  *
  * revision history:
  *  v1.0 Creation (21/11/2024)
+ *  v1.1 LN messages are handled as a view on the RX message slot (16/10/2026)
+ *  v1.2 retry the LN messages when the LN TX queue is full (16/10/2026)
+ *  v1.3 KAW reports are transmitted with high priority (16/10/2026)
+ *  v1.4 latest state wins for the KAW and S reports (16/10/2026)
+ *  v1.5 seed the LN random generator with the DIP switch address (16/10/2026)
+ *  v1.6 LN statistics readable with a peer transfer (16/10/2026)
+ *  v1.7 optional ISR profiler, readable with a peer transfer (16/10/2026)
+ *  v1.8 the LN messages are built and queued in a critical section
+ *       (the received LN messages are handled in the main loop) (16/10/2026)
+ *  v1.9 LN RX opcode table with a handler per opcode (16/10/2026)
+ *  v1.10 cached (debounced) DIP switch address with match keys (16/10/2026)
+ *  v1.11 LN report templates per channel, no shared LN TX message
+ *        (16/10/2026)
+ *  v1.12 state responder for OPC_SW_STATE, interrogate and OPC_GPON
+ *        (16/10/2026)
+ *  v1.13 optional LN trace, readable with a peer transfer (16/10/2026)
+ *  v1.14 latency from a command to its feedback, readable with a peer
+ *        transfer (16/10/2026)
+ *  v1.15 the pending LN messages are transmitted from the main loop
+ *        (16/10/2026)
+ *  v1.16 the LN statistics are read in a critical section (16/10/2026)
+ *  v1.17 the CAW and the aspect are set in a critical section (16/10/2026)
+ *  v1.18 the DIP switch address is read before the interrupts are enabled
+ *        and debounced in the main loop (16/10/2026)
+ *  v1.19 the LN report templates are set in a critical section (16/10/2026)
+ *  v1.20 the LN random generator is seeded before the LN initialisation
+ *        (16/10/2026)
+ *  v1.21 the status of a report is read in the critical section of the
+ *        report (16/10/2026)
+ *  v1.22 only the commanded end state confirms the latency of a command
+ *        (16/10/2026)
+ *  v1.23 D1 of a peer transfer is decoded with its msb (PXCT1) (16/10/2026)
+ *  v1.24 the LN trace is released when a dump is abandoned (16/10/2026)
  */
 
 #include "general.h"
 
+// LN RX opcode table, the LN messages handled by the device (with their
+// length), the LN receiver skips all other LN messages
+const lnRxOpcode_t lnRxOpcodeTable[] = {
+    {0xb0, 0x04, &lnRxSwReqHandler}, // OPC_SW_REQ
+    {0xbc, 0x04, &lnRxSwStateHandler}, // OPC_SW_STATE
+    {0xed, 0x0b, &lnRxImmPacketHandler}, // OPC_IMM_PACKET
+    {0xe5, 0x10, &lnRxPeerXferHandler}, // OPC_PEER_XFER
+    {0x82, 0x02, &lnRxGpOffHandler}, // OPC_GPOFF
+    {0x83, 0x02, &lnRxGpOnHandler}, // OPC_GPON
+#ifdef CMD_LATENCY
+    // the echo of the own reports (the report has left LN)
+    {0xb1, 0x04, &lnRxSwRepHandler}, // OPC_SW_REP
+    {0xb2, 0x04, &lnRxInputRepHandler} // OPC_INPUT_REP
+#endif
+};
+
 // <editor-fold defaultstate="collapsed" desc="initialisation">
 
 /**
@@ -17,15 +66,33 @@
 void init()
 {
     index = 0;
+    lnTxPendingCaw = 0;
+    lnTxPendingCawValue = 0;
+    lnTxPendingKaw = 0;
+    lnTxPendingS = 0;
+    lnTxPendingTick = false;
+    dipSwitchTick = false;
 
     // after start-up, add a small delay before made the initialisation
     __delay_ms(100);
     // init EEPROM
     initEeprom();
-    // init the LN driver and give the function pointer for the callback
-    lnInit(&lnRxMessageHandler);
-    // init a temporary LN message queue for transmitting a LN message
-    initQueue(&lnTxMsg);
+    // init ports (IO pins), give the pull-ups of the DIP switches time to
+    // settle
+    initPorts();
+    __delay_us(100);
+    // read the DIP switch address before the interrupts are enabled, the
+    // match keys and the LN report templates must exist before the first
+    // LN message (the address is re-read every 20ms)
+    setDipSwitchAddress(getDipSwitchAddress());
+    dipSwitchSample = dipSwitchAddress;
+    dipSwitchCount = 0;
+    // seed the LN random generator with the DIP switch address (before
+    // lnInit, which draws the first CMP delay)
+    lnSeedRandom(dipSwitchAddress);
+    // init the LN driver and give the opcode table (with the function
+    // pointers for the callback)
+    lnInit(lnRxOpcodeTable, sizeof (lnRxOpcodeTable) / sizeof (lnRxOpcode_t));
     // init the aw driver
     awInit(&awCawHandler, &awKawHandler);
     // init Belgium signal driver
@@ -38,10 +105,16 @@ void init()
     initIsr();
     // init MAX7219
     MAX7219_init();
-    // init ports (IO pins)
-    initPorts();    
     // get previous values of AW and S from EEPROM
     readEepromData();
+#ifdef ISR_PROFILE
+    // init the ISR profiler (timer 5)
+    profileInit();
+#endif
+#ifdef CMD_LATENCY
+    // init the latency histograms
+    latencyInit();
+#endif
 }
 
 /**
@@ -126,13 +199,17 @@ void initPorts()
  */
 void __interrupt(high_priority) isrHigh(void)
 {
+    PROFILE_BEGIN(isrTime);
+
     if (PIR6bits.CCP1IF)
     {
         // comparator (CCP1) interrupt
         // clear the interrupt flag and handle the request
         PIR6bits.CCP1IF = false;
         // handle interrupt routines
+        PROFILE_BEGIN(ccp1Time);
         servoIsrCcp1();
+        PROFILE_END(PROFILE_SERVO_CCP1, ccp1Time);
     }
     if (PIR2bits.HLVDIF)
     {
@@ -144,6 +221,7 @@ void __interrupt(high_priority) isrHigh(void)
         // store immediately all data to EEPROM
         writeEepromData();
     }
+    PROFILE_END(PROFILE_ISR_HIGH, isrTime);
 }
 
 // </editor-fold>
@@ -162,17 +240,25 @@ void __interrupt(low_priority) isrLow(void)
     // THE MAXIMUM TIME OF THIS ROUTINE SHOULD NOT EXCEED 600uS !!!
     // this is the time of the EUSART to receive 1 byte
     // otherwise it is possible the EUSART recieve buffer becomes is an overload
+    // (with ISR_PROFILE, the time of isrLow includes the time of isrHigh when
+    // it interrupts isrLow)
+    PROFILE_BEGIN(isrTime);
+
     if (PIE4bits.TMR1IE && PIR4bits.TMR1IF)
     {
         // timer 1 interrupt
         // clear the interrupt flag and handle the request
         PIR4bits.TMR1IF = false;
+        PROFILE_BEGIN(tmr1Time);
         lnIsrTmr1();
+        PROFILE_END(PROFILE_LN_TMR1, tmr1Time);
     }
     if (PIE3bits.TX1IE && PIR3bits.TX1IF)
     {
         // EUSART TX interrupt
+        PROFILE_BEGIN(txTime);
         lnIsrTx();
+        PROFILE_END(PROFILE_LN_TX, txTime);
     }
     if (PIE3bits.RC1IE && PIR3bits.RC1IF)
     {
@@ -180,6 +266,14 @@ void __interrupt(low_priority) isrLow(void)
         if (RC1STAbits.FERR || RC1STAbits.OERR)
         {
             // EUSART framing error (linebreak detected) or overrun error
+            if (RC1STAbits.FERR)
+            {
+                lnStats.framingErrors++;
+            }
+            if (RC1STAbits.OERR)
+            {
+                lnStats.overruns++;
+            }
             // read RCREG to clear the interrupt flag and FERR bit
              _ = RC1REG;
             // OERR can be cleared by resetting the CREN bit
@@ -195,7 +289,9 @@ void __interrupt(low_priority) isrLow(void)
         {
             // EUSART data received
             // handle the received data
+            PROFILE_BEGIN(rcTime);
             lnIsrRc(RC1REG);
+            PROFILE_END(PROFILE_LN_RC, rcTime);
         }
     }
     if (PIE4bits.TMR3IE && PIR4bits.TMR3IF)
@@ -209,14 +305,32 @@ void __interrupt(low_priority) isrLow(void)
         index &= 0x07;
 
         // first handle servo interrupt routine
+        PROFILE_BEGIN(servoTime);
         servoIsrTmr3(index);
+        PROFILE_END(PROFILE_SERVO_TMR3, servoTime);
         // reload timer 3
         WRITETIMER3(~TIMER3_2500us); // set delay in timer 3
+        // time base of the latency measurement
+        LATENCY_TICK();
+        // time base of the release of the LN trace
+        LN_TRACE_TICK();
         // set comparator (CCP1)
         CCPR1 = ~(TIMER3_2500us - (servoPortD[index] * 2));
         // at last handle signal interrupt routine
+        PROFILE_BEGIN(sTime);
         sIsrTmr3();
+        PROFILE_END(PROFILE_S_TMR3, sTime);
+        // re-read the DIP switch address (every servo period of 20ms, in
+        // the main loop, see dipSwitchHandler)
+        if (index == 0)
+        {
+            dipSwitchTick = true;
+        }
+        // retry the LN messages that didn't fit in the LN TX queue (in the
+        // main loop, see lnTxPendingHandler)
+        lnTxPendingTick = true;
     }
+    PROFILE_END(PROFILE_ISR_LOW, isrTime);
 }
 
 // </editor-fold>
@@ -317,83 +431,289 @@ void updateLeds(void)
 }
 
 /**
- * this is the callback function for the LN receiver
- * @param lnRxMsg: the lN message queue
+ * LN RX handler of a switch request (OPC_SW_REQ)
+ * @param lnRxMsg: the received LN message
+ * @param length: the length of the LN message
  */
-void lnRxMessageHandler(lnQueue_t* lnRxMsg)
+void lnRxSwReqHandler(uint8_t* lnRxMsg, uint8_t length)
 {
-    while (!isQueueEmpty(lnRxMsg))
+    // SW1 = 0, A6 - A0 and SW2 = 0, 0, DIR, ON, A10 - A7
+    // (A3 - A10 = board address, A0 - A2 = index of AW)
+    uint8_t index = lnRxMsg[1] & 0x07;
+
+    // interrogate (addresses 1017 - 1020), every board answers on 1 of the 4
+    // addresses (A0 - A1 = A3 - A4 of the board address), so the bursts of
+    // the boards are spread over the interrogate sequence
+    if (((lnRxMsg[1] & 0x7c) == LN_INTERROGATE_SW1) &&
+            ((lnRxMsg[2] & 0x0f) == LN_INTERROGATE_SW2))
     {
-        // analyse the received LN message from queue
-        switch (lnRxMsg->values[lnRxMsg->head])
+        if ((lnRxMsg[1] & 0x03) == (dipSwitchAddress & 0x03))
         {
-            case 0xb0:
-            {
-                // switch function request
-                uint8_t lnAddress;
-                uint8_t index;
-
-                lnAddress = (lnRxMsg->values[(lnRxMsg->head + 1) % QUEUE_SIZE] & 0x78) >> 3;
-                lnAddress += (lnRxMsg->values[(lnRxMsg->head + 2) % QUEUE_SIZE] & 0x0f) << 4;
-                index = lnRxMsg->values[(lnRxMsg->head + 1) % QUEUE_SIZE] & 0x07;
-
-                if (lnAddress == getDipSwitchAddress())
-                {
-                    if ((lnRxMsg->values[(lnRxMsg->head + 2) % QUEUE_SIZE] & 0x20) == 0x20)
-                    {
-                        // bit DIR = true -> CAWL = true, CAWR = false
-                        setCAWL(index, true);
-                        setCAWR(index, false);
-                    }
-                    else
-                    {
-                        // bit DIR = false -> CAWL = false, CAWR = true
-                        setCAWL(index, false);
-                        setCAWR(index, true);
-                    }
-                }
-                break;
-            }
-            case 0x82:
-            {
-                // global power OFF request
-                for (uint8_t index = 0; index < 8; index++)
-                {
-                    setCAWL(index, false);
-                    setCAWR(index, false);
-                }
-                break;
-            }
-            case 0x83:
-            {
-                // global power ON request
-                getLastAwState();
-                break;
-            }
-            case 0xed:
-            {
-                // immediate packet (used for signal aspect)
-                if (lnRxMsg->values[(lnRxMsg->head + 1) % QUEUE_SIZE] == 0x0b)
-                {
-                    uint8_t IM1 = lnRxMsg->values[(lnRxMsg->head + 5) % QUEUE_SIZE];
-                    uint8_t IM2 = lnRxMsg->values[(lnRxMsg->head + 6) % QUEUE_SIZE];
-                    uint8_t IM3 = lnRxMsg->values[(lnRxMsg->head + 7) % QUEUE_SIZE];
-
-                    uint8_t myAddress = getDipSwitchAddress();
-                    uint16_t lnAddress = getAddressFromOpcImmPacket(IM1, IM2);
-                    if (myAddress == (uint8_t) (lnAddress >> 3))
-                    {
-                        setAspect((uint8_t) (lnAddress & 0x07), IM3);
-                    }
-                }
-                break;
-            }
+            lnTxStateHandler();
+        }
+        return;
+    }
+    if (((lnRxMsg[1] & 0x78) == lnSwKey1) &&
+            ((lnRxMsg[2] & 0x0f) == lnSwKey2))
+    {
+        // awUpdateServo (isrLow) may not see the state between CAWL and CAWR
+        // (CAWL = CAWR drives the servo to the middle)
+        LN_TX_LOCK(giel);
+        if ((lnRxMsg[2] & 0x20) == 0x20)
+        {
+            // bit DIR = true -> CAWL = true, CAWR = false
+            setCAWL(index, true);
+            setCAWR(index, false);
+        }
+        else
+        {
+            // bit DIR = false -> CAWL = false, CAWR = true
+            setCAWL(index, false);
+            setCAWR(index, true);
         }
-        // clear the received LN message from queue
-        deQueue(lnRxMsg);
+        // the command is confirmed by the requested end position
+        LATENCY_COMMAND(LATENCY_AW + index, ((lnRxMsg[2] & 0x20) == 0x20) ?
+                LATENCY_KAWL : LATENCY_KAWR, getLatencyAwState(index));
+        LN_TX_UNLOCK(giel);
+    }
+}
+
+/**
+ * LN RX handler of a global power OFF request (OPC_GPOFF)
+ * @param lnRxMsg: the received LN message
+ * @param length: the length of the LN message
+ */
+void lnRxGpOffHandler(uint8_t* lnRxMsg, uint8_t length)
+{
+    for (uint8_t index = 0; index < 8; index++)
+    {
+        LN_TX_LOCK(giel);
+        setCAWL(index, false);
+        setCAWR(index, false);
+        LN_TX_UNLOCK(giel);
+    }
+}
+
+/**
+ * LN RX handler of a global power ON request (OPC_GPON)
+ * @param lnRxMsg: the received LN message
+ * @param length: the length of the LN message
+ */
+void lnRxGpOnHandler(uint8_t* lnRxMsg, uint8_t length)
+{
+    LN_TX_LOCK(giel);
+    getLastAwState();
+    LN_TX_UNLOCK(giel);
+    // report the state of all AW and S
+    lnTxStateHandler();
+}
+
+/**
+ * LN RX handler of a request for the state of a switch (OPC_SW_STATE), the
+ * reply is a long acknowledge (OPC_LONG_ACK) with the end position of the AW
+ * LOPC = 0x3c (OPC_SW_STATE & 0x7f)
+ * ACK1 = 0, 0, DIR, ON, 0, 0, 0, 0
+ *       (DIR = KAWL, ON = the AW is in an end position, KAWL or KAWR)
+ * @param lnRxMsg: the received LN message
+ * @param length: the length of the LN message
+ */
+void lnRxSwStateHandler(uint8_t* lnRxMsg, uint8_t length)
+{
+    // SW1 = 0, A6 - A0 and SW2 = 0, 0, 0, 0, A10 - A7
+    uint8_t index = lnRxMsg[1] & 0x07;
+
+    if (((lnRxMsg[1] & 0x78) != lnSwKey1) ||
+            ((lnRxMsg[2] & 0x0f) != lnSwKey2))
+    {
+        return;
+    }
+    uint8_t lnTxMsg[LN_TEMPLATE_SIZE];
+    uint8_t ack1 = 0x00;
+    if (awList[index].KAWL)
+    {
+        ack1 |= 0x30;
+    }
+    else if (awList[index].KAWR)
+    {
+        ack1 |= 0x10;
     }
+    lnTxMsg[0] = 0xB4;
+    lnTxMsg[1] = 0x3C;
+    lnTxMsg[2] = ack1;
+    lnTxMsg[3] = 0xff ^ 0xB4 ^ 0x3C ^ ack1;
+    // the requester waits for the reply, so high priority (the requester
+    // repeats the request if the LN TX queue is full)
+    LN_TX_LOCK(giel);
+    lnTxMessageHandler(lnTxMsg, LN_TEMPLATE_SIZE, LN_TX_PRIO_HIGH);
+    LN_TX_UNLOCK(giel);
 }
 
+/**
+ * LN RX handler of an immediate packet (OPC_IMM_PACKET, used for the signal
+ * aspect), the length is checked by the LN receiver (opcode table)
+ * @param lnRxMsg: the received LN message
+ * @param length: the length of the LN message
+ */
+void lnRxImmPacketHandler(uint8_t* lnRxMsg, uint8_t length)
+{
+    uint8_t IM1 = lnRxMsg[5];
+    uint8_t IM2 = lnRxMsg[6];
+    uint8_t IM3 = lnRxMsg[7];
+
+    // compare the raw address bits of IM1 and IM2 with the board address
+    // (refer to getAddressFromOpcImmPacket), A0 - A2 = index of S
+    if (((IM1 & 0x3e) == lnImKey1) && ((IM2 & 0x70) == lnImKey2))
+    {
+        uint8_t index = (uint8_t) (((IM1 & 0x01) << 2) | ((IM2 >> 1) & 0x03));
+        // sIsrTmr3 reads the aspect and setKAWL/setKAWR (isrLow) rebuild
+        // the EEPROM data, like setAspect
+        LN_TX_LOCK(giel);
+        setAspect(index, IM3);
+        // the command is confirmed by KFS (aspect R) or KOS (open signal)
+        LATENCY_COMMAND(LATENCY_S + index, (sList[index].aspect == 0) ?
+                LATENCY_KFS : LATENCY_KOS, getLatencySState(index));
+        LN_TX_UNLOCK(giel);
+    }
+}
+
+/**
+ * LN RX handler of a peer transfer (OPC_PEER_XFER, used to read the LN
+ * statistics), SRC = requester, DSTL/DSTH = board address, D1 = request +
+ * page, the length is checked by the LN receiver (opcode table)
+ * @param lnRxMsg: the received LN message
+ * @param length: the length of the LN message
+ */
+void lnRxPeerXferHandler(uint8_t* lnRxMsg, uint8_t length)
+{
+    if ((lnRxMsg[3] != (dipSwitchAddress & 0x7f)) ||
+            (lnRxMsg[4] != (dipSwitchAddress >> 7)))
+    {
+        return;
+    }
+    // D1 with its msb (bit 0 of PXCT1), the requests and the replies have
+    // disjoint codes
+    uint8_t request = (uint8_t) (lnRxMsg[6] | ((lnRxMsg[5] & 0x01) << 7));
+    if ((request & 0xf0) == LN_STATS_REQUEST)
+    {
+        lnStatsHandler(lnRxMsg[2], request & 0x0f);
+    }
+#ifdef ISR_PROFILE
+    // D1 = request + page, D2 = source
+    if ((request & 0xf0) == LN_PROFILE_REQUEST)
+    {
+        lnProfileHandler(lnRxMsg[2], lnRxMsg[7], request & 0x0f);
+    }
+#endif
+#ifdef LN_TRACE
+    // D1 = request, D2 = chunk
+    if ((request & 0xf0) == LN_TRACE_REQUEST)
+    {
+        lnTraceHandler(lnRxMsg[2], lnRxMsg[7]);
+    }
+#endif
+#ifdef CMD_LATENCY
+    // D1 = request + page, D2 = histogram
+    if ((request & 0xf0) == LN_LATENCY_REQUEST)
+    {
+        lnLatencyHandler(lnRxMsg[2], lnRxMsg[7], request & 0x0f);
+    }
+#endif
+}
+
+#ifdef CMD_LATENCY
+
+/**
+ * LN RX handler of a turnout sensor state report (OPC_SW_REP), the echo of
+ * the KAW report of this board has left LN, the report of the commanded end
+ * position (C = KAWL or T = KAWR) ends the latency measurement of the AW
+ * @param lnRxMsg: the received LN message
+ * @param length: the length of the LN message
+ */
+void lnRxSwRepHandler(uint8_t* lnRxMsg, uint8_t length)
+{
+    // SN1 = 0, A6 - A0 and SN2 = 0, 0, C, T, A10 - A7
+    if (((lnRxMsg[1] & 0x78) == lnSwKey1) &&
+            ((lnRxMsg[2] & 0x0f) == lnSwKey2) && ((lnRxMsg[2] & 0x30) != 0))
+    {
+        uint8_t state = 0;
+        if (lnRxMsg[2] & 0x20)
+        {
+            state |= LATENCY_KAWL;
+        }
+        if (lnRxMsg[2] & 0x10)
+        {
+            state |= LATENCY_KAWR;
+        }
+        LN_TX_LOCK(giel);
+        LATENCY_REPORTED(LATENCY_AW + (lnRxMsg[1] & 0x07), state);
+        LN_TX_UNLOCK(giel);
+    }
+}
+
+/**
+ * LN RX handler of a general sensor state report (OPC_INPUT_REP), the echo
+ * of the S report of this board has left LN, the report of the actual KFS
+ * state ends the latency measurement of the S (if it is the commanded state)
+ * @param lnRxMsg: the received LN message
+ * @param length: the length of the LN message
+ */
+void lnRxInputRepHandler(uint8_t* lnRxMsg, uint8_t length)
+{
+    // IN1 = 0, A6 - A0 and IN2 = 0, X, I, L, A10 - A7 (L = KFS)
+    uint8_t index = lnRxMsg[1] & 0x07;
+
+    if (((lnRxMsg[1] & 0x78) == lnSwKey1) &&
+            ((lnRxMsg[2] & 0x0f) == lnSwKey2) &&
+            (((lnRxMsg[2] & 0x10) == 0x10) == sList[index].KFS))
+    {
+        LN_TX_LOCK(giel);
+        // L = 0 is an open signal for the measurement (the report of KOS)
+        LATENCY_REPORTED(LATENCY_S + index,
+                (lnRxMsg[2] & 0x10) ? LATENCY_KFS : LATENCY_KOS);
+        LN_TX_UNLOCK(giel);
+    }
+}
+
+/**
+ * get the end state of an AW for the latency measurement
+ * @param index: the index of AW in the AW list
+ * @return LATENCY_KAWL and/or LATENCY_KAWR (0 between the end positions)
+ */
+uint8_t getLatencyAwState(uint8_t index)
+{
+    uint8_t state = 0;
+    if (awList[index].KAWL)
+    {
+        state |= LATENCY_KAWL;
+    }
+    if (awList[index].KAWR)
+    {
+        state |= LATENCY_KAWR;
+    }
+    return state;
+}
+
+/**
+ * get the end state of a S for the latency measurement
+ * @param index: the index of S in the S list
+ * @return LATENCY_KFS and/or LATENCY_KOS (0 between the end states)
+ */
+uint8_t getLatencySState(uint8_t index)
+{
+    uint8_t state = 0;
+    if (sList[index].KFS)
+    {
+        state |= LATENCY_KFS;
+    }
+    if (sList[index].KOS)
+    {
+        state |= LATENCY_KOS;
+    }
+    return state;
+}
+
+#endif
+
 /**
  * this is the callback function for the AW (when the CAW status is changed)
  * @param index: the index of AW in the AW list
@@ -416,23 +736,32 @@ void awCawHandler(uint8_t index, bool value)
     //      (DIR = true -> CAWL = true and CAWR = false,
     //      DIR = false -> CAWL = false and CAWR = true)
 
-    // get DIP switch address
-    uint8_t address = getDipSwitchAddress();
+    // status bits of SW2 (ON is set in the template)
+    uint8_t status = value ? 0x20 : 0x00;
+    uint8_t lnTxMsg[LN_TEMPLATE_SIZE];
 
-    // make arguments SW1, SW2
-    uint8_t SW1 = ((uint8_t) ((address << 3) & 0x00f8) + index) & 0x7f;
-    uint8_t SW2 = ((uint8_t) (address >> 4) & 0x0f) + 0x10;
-    if (value)
+    // make the LN message from the template of the AW
+    LN_TX_LOCK(giel);
+    getLnTxTemplate(lnTxMsg, lnCawTemplate[index], status);
+    // transmit the LN message (if the LN TX queue is full, try again later)
+    if (lnTxMessageHandler(lnTxMsg, LN_TEMPLATE_SIZE, LN_TX_PRIO_LOW) ==
+            LN_TX_FULL)
+    {
+        lnTxPendingCaw |= (uint8_t) (1 << index);
+        if (value)
+        {
+            lnTxPendingCawValue |= (uint8_t) (1 << index);
+        }
+        else
+        {
+            lnTxPendingCawValue &= (uint8_t) ~(1 << index);
+        }
+    }
+    else
     {
-        SW2 |= 0x20;
+        lnTxPendingCaw &= (uint8_t) ~(1 << index);
     }
-
-    // enqueue message
-    enQueue(&lnTxMsg, 0xB0);
-    enQueue(&lnTxMsg, SW1);
-    enQueue(&lnTxMsg, SW2);
-    // transmit the LN message
-    lnTxMessageHandler(&lnTxMsg);
+    LN_TX_UNLOCK(giel);
 }
 
 /**
@@ -455,27 +784,37 @@ void awKawHandler(uint8_t index)
     //       (A7 - A10 = DIP switches 4 - 7)
     //       (C = KAWL, T = KAWR)
 
-    // get DIP switch address
-    uint8_t address = getDipSwitchAddress();
+    uint8_t lnTxMsg[LN_TEMPLATE_SIZE];
 
-    // make arguments SN1, SN2
-    uint8_t SN1 = ((uint8_t) ((address << 3) & 0x00f8) + index) & 0x7f;
-    uint8_t SN2 = (uint8_t) (address >> 4) & 0x0f;
+    // the status is read in the critical section, so isrLow can't queue a
+    // newer report between the read and this report (latest state wins)
+    LN_TX_LOCK(giel);
+    // status bits of SN2
+    uint8_t status = 0x00;
     if (awList[index].KAWR)
     {
-        SN2 |= 0x10;
+        status |= 0x10;
     }
     if (awList[index].KAWL)
     {
-        SN2 |= 0x20;
+        status |= 0x20;
     }
-
-    // enqueue message
-    enQueue(&lnTxMsg, 0xB1);
-    enQueue(&lnTxMsg, SN1);
-    enQueue(&lnTxMsg, SN2);
-    // transmit the LN message
-    lnTxMessageHandler(&lnTxMsg);
+    // make the LN message from the template of the AW
+    getLnTxTemplate(lnTxMsg, lnKawTemplate[index], status);
+    // transmit the LN message (if the LN TX queue is full, try again later)
+    // the end position of the AW gates the route setting, so high priority
+    if (lnTxReportHandler(lnTxMsg, LN_TEMPLATE_SIZE, LN_TX_PRIO_HIGH) ==
+            LN_TX_FULL)
+    {
+        lnTxPendingKaw |= (uint8_t) (1 << index);
+    }
+    else
+    {
+        lnTxPendingKaw &= (uint8_t) ~(1 << index);
+    }
+    // the commanded end position confirms the command of the AW
+    LATENCY_CONFIRMED(LATENCY_AW + index, getLatencyAwState(index));
+    LN_TX_UNLOCK(giel);
 }
 
 /**
@@ -498,23 +837,305 @@ void sHandler(uint8_t index)
     //       (A7 - A10 = DIP switches 4 - 7)
     //       (I = 0 - DS54, L = KFS state)
 
-    // get DIP switch address
-    uint8_t address = getDipSwitchAddress();
+    uint8_t lnTxMsg[LN_TEMPLATE_SIZE];
 
-    // make arguments SN1, SN2
-    uint8_t IN1 = ((uint8_t) ((address << 3) & 0x00f8) + index) & 0x7f;
-    uint8_t IN2 = (uint8_t) (address >> 4) & 0x0f;
-    if (sList[index].KFS)
+    // the status is read in the critical section, so isrLow can't queue a
+    // newer report between the read and this report (latest state wins)
+    LN_TX_LOCK(giel);
+    // status bits of IN2
+    uint8_t status = sList[index].KFS ? 0x10 : 0x00;
+    // make the LN message from the template of the S
+    getLnTxTemplate(lnTxMsg, lnSTemplate[index], status);
+    // transmit the LN message (if the LN TX queue is full, try again later)
+    if (lnTxReportHandler(lnTxMsg, LN_TEMPLATE_SIZE, LN_TX_PRIO_LOW) ==
+            LN_TX_FULL)
+    {
+        lnTxPendingS |= (uint8_t) (1 << index);
+    }
+    else
+    {
+        lnTxPendingS &= (uint8_t) ~(1 << index);
+    }
+    // the commanded KOS or KFS confirms the command of the S
+    LATENCY_CONFIRMED(LATENCY_S + index, getLatencySState(index));
+    LN_TX_UNLOCK(giel);
+}
+
+/**
+ * reply to a request for the LN statistics (bus health) with a peer transfer
+ * OPCODE = 0xE5 (OPC_PEER_XFER), length = 0x10
+ * SRC = board address (A0 - A6), DSTL = requester, DSTH = 0
+ * PXCT1 = msb of D1 - D4, PXCT2 = msb of D5 - D8
+ * D1 = LN_STATS_REPLY + page, D2 - D7 = 3 counters (lsb, msb),
+ * D8 = number of pages
+ * @param requester: the source of the request
+ * @param page: the page with the counters (0 - LN_STATS_PAGES - 1)
+ */
+void lnStatsHandler(uint8_t requester, uint8_t page)
+{
+    uint16_t counters[3];
+    uint8_t data[8];
+
+    if (page >= LN_STATS_PAGES)
+    {
+        return;
+    }
+    // isrLow updates the counters (16 bit), take a snapshot
+    LN_TX_LOCK(giel);
+    switch (page)
+    {
+        case 0:
+            counters[0] = lnStats.framingErrors;
+            counters[1] = lnStats.overruns;
+            counters[2] = lnStats.checksumErrors;
+            break;
+        case 1:
+            counters[0] = lnStats.collisions;
+            counters[1] = lnStats.linebreaks;
+            counters[2] = lnStats.rxDroppedBytes;
+            break;
+        case 2:
+            counters[0] = lnStats.txRejected;
+            counters[1] = lnStats.txHighWater[LN_TX_PRIO_HIGH];
+            counters[2] = lnStats.txHighWater[LN_TX_PRIO_LOW];
+            break;
+        case 3:
+            counters[0] = lnStats.rxHighWater;
+            counters[1] = lnStats.attempts;
+            counters[2] = lnStats.drops;
+            break;
+    }
+    LN_TX_UNLOCK(giel);
+    data[0] = LN_STATS_REPLY + page;
+    for (uint8_t i = 0; i < 3; i++)
+    {
+        data[1 + (i * 2)] = (uint8_t) (counters[i] & 0xff);
+        data[2 + (i * 2)] = (uint8_t) (counters[i] >> 8);
+    }
+    data[7] = LN_STATS_PAGES;
+    lnPeerXferHandler(requester, data);
+}
+
+#ifdef ISR_PROFILE
+
+/**
+ * LN ISR profile handler, sends a page of the profile of 1 source to the
+ * requester (with a peer transfer, D1 = LN_PROFILE_REPLY + page, D2 - D7 =
+ * 3 values of 16 bit in timer 5 ticks or counts, D8 = source)
+ * page 0 = min, avg, max, page 1 = bins 0 - 2, page 2 = bins 3 - 5
+ * @param requester: the LN address of the requester (SRC of the request)
+ * @param source: the source (see profileSource_t)
+ * @param page: the page with the values
+ */
+void lnProfileHandler(uint8_t requester, uint8_t source, uint8_t page)
+{
+    uint16_t values[3];
+    uint8_t data[8];
+
+    if ((source >= PROFILE_SOURCES) || (page >= LN_PROFILE_PAGES))
+    {
+        return;
+    }
+    // isrHigh can update its profile while we are reading it
+    INTCONbits.GIEH = false;
+    if (page == 0)
+    {
+        values[0] = profileList[source].min;
+        values[1] = profileGetAverage(source);
+        values[2] = profileList[source].max;
+    }
+    else
+    {
+        for (uint8_t i = 0; i < 3; i++)
+        {
+            values[i] = profileList[source].bins[((page - 1) * 3) + i];
+        }
+    }
+    INTCONbits.GIEH = true;
+    data[0] = LN_PROFILE_REPLY + page;
+    for (uint8_t i = 0; i < 3; i++)
     {
-        IN2 |= 0x10;
+        data[1 + (i * 2)] = (uint8_t) (values[i] & 0xff);
+        data[2 + (i * 2)] = (uint8_t) (values[i] >> 8);
     }
+    data[7] = source;
+    lnPeerXferHandler(requester, data);
+}
+
+#endif
 
-    // enqueue message
-    enQueue(&lnTxMsg, 0xB2);
-    enQueue(&lnTxMsg, IN1);
-    enQueue(&lnTxMsg, IN2);
-    // transmit the LN message
-    lnTxMessageHandler(&lnTxMsg);
+#ifdef LN_TRACE
+
+/**
+ * LN trace handler, sends a chunk of the trace (2 entries) to the requester
+ * (with a peer transfer, D1 = LN_TRACE_REPLY + chunk, D2 = flags of both
+ * entries, D3 - D5 and D6 - D8 = time (lsb, msb) and byte of the entries)
+ * reading chunk 0 freezes the trace till the last chunk is read, or till no
+ * chunk is read during LN_TRACE_RELEASE_TICKS (abandoned dump)
+ * @param requester: the LN address of the requester (SRC of the request)
+ * @param chunk: the chunk (0 - LN_TRACE_CHUNKS - 1)
+ */
+void lnTraceHandler(uint8_t requester, uint8_t chunk)
+{
+    uint8_t data[8];
+
+    if (chunk >= LN_TRACE_CHUNKS)
+    {
+        return;
+    }
+    data[0] = LN_TRACE_REPLY + chunk;
+    // isrLow adds the entries and releases the trace (the trace is frozen
+    // by chunk 0)
+    LN_TX_LOCK(giel);
+    getLnTraceChunk(&data[1], chunk);
+    LN_TX_UNLOCK(giel);
+    lnPeerXferHandler(requester, data);
+}
+
+#endif
+
+#ifdef CMD_LATENCY
+
+/**
+ * LN latency handler, sends a page of a latency histogram to the requester
+ * (with a peer transfer, D1 = LN_LATENCY_REPLY + page, D2 - D7 = 3 values of
+ * 16 bit in ticks of 2.5ms or counts, D8 = histogram)
+ * page 0 = max, bins 0 - 1, page 1 = bins 2 - 4, page 2 = bins 5 - 7
+ * @param requester: the LN address of the requester (SRC of the request)
+ * @param histogram: the histogram (channel * LATENCY_STAGES + stage)
+ * @param page: the page with the values
+ */
+void lnLatencyHandler(uint8_t requester, uint8_t histogram, uint8_t page)
+{
+    uint16_t values[3];
+    uint8_t data[8];
+
+    if ((histogram >= (LATENCY_CHANNELS * LATENCY_STAGES)) ||
+            (page >= LN_LATENCY_PAGES))
+    {
+        return;
+    }
+    latency_t* latency = &latencyList[histogram / LATENCY_STAGES]
+            [histogram % LATENCY_STAGES];
+    // isrLow adds the latencies
+    LN_TX_LOCK(giel);
+    for (uint8_t i = 0; i < 3; i++)
+    {
+        uint8_t value = (uint8_t) ((page * 3) + i);
+        values[i] = (value == 0) ? latency->max : latency->bins[value - 1];
+    }
+    LN_TX_UNLOCK(giel);
+    data[0] = LN_LATENCY_REPLY + page;
+    for (uint8_t i = 0; i < 3; i++)
+    {
+        data[1 + (i * 2)] = (uint8_t) (values[i] & 0xff);
+        data[2 + (i * 2)] = (uint8_t) (values[i] >> 8);
+    }
+    data[7] = histogram;
+    lnPeerXferHandler(requester, data);
+}
+
+#endif
+
+/**
+ * LN peer transfer handler, transmits 8 data bytes to the requester
+ * (OPC_PEER_XFER, SRC = board address, DSTL = requester)
+ * @param requester: the LN address of the requester
+ * @param data: the 8 data bytes (D1 - D8)
+ */
+void lnPeerXferHandler(uint8_t requester, uint8_t* data)
+{
+    uint8_t lnTxMsg[0x10];
+    uint8_t length = 0;
+
+    // make message
+    lnTxMsg[length++] = 0xE5;
+    lnTxMsg[length++] = 0x10;
+    lnTxMsg[length++] = dipSwitchAddress & 0x7f;
+    lnTxMsg[length++] = requester & 0x7f;
+    lnTxMsg[length++] = 0x00;
+    for (uint8_t i = 0; i < 8; i += 4)
+    {
+        // PXCT = msb of the next 4 data bytes
+        uint8_t pxct = 0;
+        for (uint8_t j = 0; j < 4; j++)
+        {
+            pxct |= (uint8_t) ((data[i + j] >> 7) << j);
+        }
+        lnTxMsg[length++] = pxct;
+        for (uint8_t j = 0; j < 4; j++)
+        {
+            lnTxMsg[length++] = data[i + j] & 0x7f;
+        }
+    }
+    uint8_t checksum = 0xff;
+    for (uint8_t i = 0; i < length; i++)
+    {
+        checksum ^= lnTxMsg[i];
+    }
+    lnTxMsg[length++] = checksum;
+    // transmit the LN message (the requester repeats the request if the
+    // LN TX queue is full)
+    LN_TX_LOCK(giel);
+    lnTxMessageHandler(lnTxMsg, length, LN_TX_PRIO_LOW);
+    LN_TX_UNLOCK(giel);
+}
+
+/**
+ * report the state of all AW (OPC_SW_REP) and S (OPC_INPUT_REP) in 1 burst
+ * (answer to an interrogate or OPC_GPON), the reports are marked as pending
+ * and lnTxPendingHandler transmits them as soon as the LN TX queue has space
+ */
+void lnTxStateHandler(void)
+{
+    LN_TX_LOCK(giel);
+    lnTxPendingKaw = 0xff;
+    lnTxPendingS = 0xff;
+    LN_TX_UNLOCK(giel);
+}
+
+/**
+ * transmit the LN messages that didn't fit in the LN TX queue
+ * (the reports contain the actual state of the AW and S)
+ * this routine is called in the main loop, it retries once per tick of
+ * timer 3 (2.5ms), every LN message is queued in its own critical section
+ * so a burst of 16 reports (interrogate) doesn't block isrLow
+ */
+void lnTxPendingHandler(void)
+{
+    if (!lnTxPendingTick)
+    {
+        return;
+    }
+    lnTxPendingTick = false;
+    if ((lnTxPendingCaw | lnTxPendingKaw | lnTxPendingS) == 0)
+    {
+        return;
+    }
+    for (uint8_t i = 0; i < 8; i++)
+    {
+        uint8_t mask = (uint8_t) (1 << i);
+        if (lnTxPendingCaw & mask)
+        {
+            // the pending bit and the value are read again in the critical
+            // section of the CAW request, isrLow can queue a newer CAW
+            // request of the AW in between (awCawHandler nests the lock)
+            LN_TX_LOCK(giel);
+            if (lnTxPendingCaw & mask)
+            {
+                awCawHandler(i, (lnTxPendingCawValue & mask) != 0);
+            }
+            LN_TX_UNLOCK(giel);
+        }
+        if (lnTxPendingKaw & mask)
+        {
+            awKawHandler(i);
+        }
+        if (lnTxPendingS & mask)
+        {
+            sHandler(i);
+        }
+    }
 }
 
 /**
@@ -538,6 +1159,107 @@ uint8_t getDipSwitchAddress()
     return address;
 }
 
+/**
+ * set the DIP switch address and the match keys (the raw address bits of the
+ * LN messages for this board)
+ * @param address: the address (or value of the DIP switches)
+ */
+void setDipSwitchAddress(uint8_t address)
+{
+    dipSwitchAddress = address;
+    // OPC_SW_REQ, OPC_SW_REP, OPC_INPUT_REP
+    // 1st byte = 0, A6 - A0 and 2nd byte = 0, x, x, x, A10 - A7
+    lnSwKey1 = (uint8_t) (address << 3) & 0x78;
+    lnSwKey2 = (uint8_t) (address >> 4) & 0x0f;
+    // OPC_IMM_PACKET (refer to getAddressFromOpcImmPacket)
+    // IM1 = x, x, A7, A6, A5, A4, A3, A2 and IM2 = x, /A10, /A9, /A8, x, x,
+    // A1, A0
+    lnImKey1 = (uint8_t) (address << 1) & 0x3e;
+    lnImKey2 = (uint8_t) (((address >> 5) ^ 0x07) << 4);
+    // the LN report templates hold the address bits
+    setLnTxTemplates();
+}
+
+/**
+ * set the LN report templates of all channels (OPC_SW_REQ of the CAW,
+ * OPC_SW_REP of the KAW and OPC_INPUT_REP of the S) with the address bits of
+ * the DIP switches, the status bits are cleared
+ * the templates of a channel are set in a critical section (the reports are
+ * also built in isrLow), so a report never has a half changed address
+ */
+void setLnTxTemplates(void)
+{
+    for (uint8_t i = 0; i < 8; i++)
+    {
+        LN_TX_LOCK(giel);
+        // SW2 = 0, 0, DIR, ON, A10 - A7 (ON = true, switch activation)
+        setLnTxTemplate(lnCawTemplate[i], 0xB0, lnSwKey1 | i, lnSwKey2 | 0x10);
+        setLnTxTemplate(lnKawTemplate[i], 0xB1, lnSwKey1 | i, lnSwKey2);
+        setLnTxTemplate(lnSTemplate[i], 0xB2, lnSwKey1 | i, lnSwKey2);
+        LN_TX_UNLOCK(giel);
+    }
+}
+
+/**
+ * set a LN report template (the checksum is the checksum with the status
+ * bits cleared)
+ * @param lnTemplate: the template
+ * @param opcode: the opcode
+ * @param byte1: the 1st data byte (address bits)
+ * @param byte2: the 2nd data byte (address bits)
+ */
+void setLnTxTemplate(uint8_t* lnTemplate, uint8_t opcode, uint8_t byte1,
+        uint8_t byte2)
+{
+    lnTemplate[0] = opcode;
+    lnTemplate[1] = byte1;
+    lnTemplate[2] = byte2;
+    lnTemplate[3] = 0xff ^ opcode ^ byte1 ^ byte2;
+}
+
+/**
+ * get a LN message from a LN report template, the status bits are set in
+ * the 2nd data byte and the checksum is patched
+ * @param lnTxMsg: the LN message (LN_TEMPLATE_SIZE bytes)
+ * @param lnTemplate: the template
+ * @param status: the status bits (of the 2nd data byte)
+ */
+void getLnTxTemplate(uint8_t* lnTxMsg, uint8_t* lnTemplate, uint8_t status)
+{
+    lnTxMsg[0] = lnTemplate[0];
+    lnTxMsg[1] = lnTemplate[1];
+    lnTxMsg[2] = lnTemplate[2] | status;
+    lnTxMsg[3] = lnTemplate[3] ^ status;
+}
+
+/**
+ * DIP switch handler (debounce), a changed DIP switch address is taken
+ * after DIP_SWITCH_DEBOUNCE equal reads
+ * this routine is called in the main loop, it reads the DIP switches once
+ * per servo period (20ms), the match keys are only changed in the main loop
+ * (where the LN RX handlers use them)
+ */
+void dipSwitchHandler(void)
+{
+    if (!dipSwitchTick)
+    {
+        return;
+    }
+    dipSwitchTick = false;
+    uint8_t address = getDipSwitchAddress();
+
+    if (address != dipSwitchSample)
+    {
+        dipSwitchSample = address;
+        dipSwitchCount = 0;
+    }
+    else if ((address != dipSwitchAddress) &&
+            (++dipSwitchCount >= DIP_SWITCH_DEBOUNCE))
+    {
+        setDipSwitchAddress(address);
+    }
+}
+
 /**
  * get the address from the OPC_IMM_PACKET
  * @param IM1: the value of IM1
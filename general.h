@@ -6,6 +6,25 @@
  * revision history:
  *  v1.0 Creation (21/11/2024)
  *  v2.0 Complete rework of the program (05/10/2025)
+ *  v2.1 LN messages are handled as a view on the RX message slot (16/10/2026)
+ *  v2.2 capacity of the LN TX message queue (16/10/2026)
+ *  v2.3 retry the LN messages when the LN TX queue is full (16/10/2026)
+ *  v2.4 LN statistics readable with a peer transfer (16/10/2026)
+ *  v2.5 optional ISR profiler, readable with a peer transfer (16/10/2026)
+ *  v2.6 LN RX handler per opcode (16/10/2026)
+ *  v2.7 cached (debounced) DIP switch address with match keys (16/10/2026)
+ *  v2.8 LN report templates per channel, no shared LN TX message
+ *       (16/10/2026)
+ *  v2.9 state responder for OPC_SW_STATE, interrogate and OPC_GPON
+ *       (16/10/2026)
+ *  v2.10 optional LN trace, readable with a peer transfer (16/10/2026)
+ *  v2.11 latency from a command to its feedback, readable with a peer
+ *        transfer (16/10/2026)
+ *  v2.12 the pending LN messages are transmitted from the main loop
+ *        (16/10/2026)
+ *  v2.13 the DIP switch address is debounced in the main loop (16/10/2026)
+ *  v2.14 end state of the AW and S for the latency measurement (16/10/2026)
+ *  v2.15 latency request outside the trace replies (16/10/2026)
  */
 
 // This is a guard condition so that contents of this file are not included
@@ -17,13 +36,49 @@
 #include "aw.h"
 #include "circular_queue.h"
 #include "eeprom.h"
+#include "latency.h"
 #include "ln.h"
 #include "MAX7219.h"
+#include "profiler.h"
 #include "s.h"
 #include "servo.h"
 
 // definitions
 #define TIMER3_2500us 5000          // timer 3 delay value, 2500sec = 5000
+// peer transfer (OPC_PEER_XFER) to read the LN statistics, D1 of the request
+// = LN_STATS_REQUEST + page, D1 of the reply = LN_STATS_REPLY + page
+#define LN_STATS_REQUEST 0x10
+#define LN_STATS_REPLY 0x20
+#define LN_STATS_PAGES 4
+// peer transfer to read the ISR profile (with ISR_PROFILE), D1 of the request
+// = LN_PROFILE_REQUEST + page and D2 = source, D1 of the reply =
+// LN_PROFILE_REPLY + page
+#define LN_PROFILE_REQUEST 0x30
+#define LN_PROFILE_REPLY 0x40
+#define LN_PROFILE_PAGES 3
+// peer transfer to read the LN trace (with LN_TRACE), D1 of the request
+// = LN_TRACE_REQUEST and D2 = chunk, D1 of the reply = LN_TRACE_REPLY + chunk
+// (0x60 - 0x7f)
+#define LN_TRACE_REQUEST 0x50
+#define LN_TRACE_REPLY 0x60
+// peer transfer to read the latency histograms (with CMD_LATENCY), D1 of the
+// request = LN_LATENCY_REQUEST + page (msb in PXCT1) and D2 = histogram
+// (channel * 2 + stage), D1 of the reply = LN_LATENCY_REPLY + page (msb in
+// PXCT1)
+// the requests and the replies have disjoint D1 codes (the trace replies use
+// 0x60 - 0x7f), so a board never answers the reply of another board
+#define LN_LATENCY_REQUEST 0x90
+#define LN_LATENCY_REPLY 0x80
+#define LN_LATENCY_PAGES 3
+// number of equal reads (1 read every 20ms) before a changed DIP switch
+// address is taken
+#define DIP_SWITCH_DEBOUNCE 4
+// length of a LN report template (opcode, 2 data bytes and checksum)
+#define LN_TEMPLATE_SIZE 4
+// interrogate = OPC_SW_REQ to the addresses 1017 - 1020 (0x3f8 - 0x3fb)
+// SW1 = 0x78 - 0x7b and A10 - A7 of SW2 = 0x07
+#define LN_INTERROGATE_SW1 0x78
+#define LN_INTERROGATE_SW2 0x07
 
 // routines
 void init(void);
@@ -35,16 +90,60 @@ void initPorts(void);
 void isrHigh(void);
 void isrLow(void);
 void updateLeds(void);
-void lnRxMessageHandler(lnQueue_t*);
+void lnRxSwReqHandler(uint8_t*, uint8_t);
+void lnRxGpOffHandler(uint8_t*, uint8_t);
+void lnRxGpOnHandler(uint8_t*, uint8_t);
+void lnRxSwStateHandler(uint8_t*, uint8_t);
+void lnRxImmPacketHandler(uint8_t*, uint8_t);
+void lnRxPeerXferHandler(uint8_t*, uint8_t);
+#ifdef CMD_LATENCY
+void lnRxSwRepHandler(uint8_t*, uint8_t);
+void lnRxInputRepHandler(uint8_t*, uint8_t);
+uint8_t getLatencyAwState(uint8_t);
+uint8_t getLatencySState(uint8_t);
+#endif
 void awCawHandler(uint8_t, bool);
 void awKawHandler(uint8_t);
 void sHandler(uint8_t);
+void lnStatsHandler(uint8_t, uint8_t);
+#ifdef ISR_PROFILE
+void lnProfileHandler(uint8_t, uint8_t, uint8_t);
+#endif
+#ifdef LN_TRACE
+void lnTraceHandler(uint8_t, uint8_t);
+#endif
+#ifdef CMD_LATENCY
+void lnLatencyHandler(uint8_t, uint8_t, uint8_t);
+#endif
+void lnPeerXferHandler(uint8_t, uint8_t*);
+void lnTxStateHandler(void);
+void lnTxPendingHandler(void);
 uint8_t getDipSwitchAddress(void);
+void setDipSwitchAddress(uint8_t);
+void dipSwitchHandler(void);
+void setLnTxTemplates(void);
+void setLnTxTemplate(uint8_t*, uint8_t, uint8_t, uint8_t);
+void getLnTxTemplate(uint8_t*, uint8_t*, uint8_t);
 uint16_t getAddressFromOpcImmPacket(uint8_t, uint8_t);
 
 // variables
-lnQueue_t lnTxMsg; //ok
+uint8_t lnTxPendingCaw; // AW with a pending CAW request (1 bit per AW)
+uint8_t lnTxPendingCawValue; // value of the pending CAW request
+uint8_t lnTxPendingKaw; // AW with a pending KAW report
+uint8_t lnTxPendingS; // S with a pending report
+bool lnTxPendingTick; // timer 3 tick, retry the pending LN messages
 uint8_t index; //ok
+uint8_t dipSwitchAddress; // DIP switch address (debounced)
+uint8_t dipSwitchSample; // last read of the DIP switches
+uint8_t dipSwitchCount; // number of equal reads of the DIP switches
+bool dipSwitchTick; // servo period (20ms), re-read the DIP switches
+uint8_t lnSwKey1; // address bits of SW1/SN1/IN1 for this board
+uint8_t lnSwKey2; // address bits of SW2/SN2/IN2 for this board
+uint8_t lnImKey1; // address bits of IM1 for this board
+uint8_t lnImKey2; // address bits of IM2 for this board
+uint8_t lnCawTemplate[8][LN_TEMPLATE_SIZE]; // OPC_SW_REQ per AW
+uint8_t lnKawTemplate[8][LN_TEMPLATE_SIZE]; // OPC_SW_REP per AW
+uint8_t lnSTemplate[8][LN_TEMPLATE_SIZE]; // OPC_INPUT_REP per S
 
 #endif	/* GENERAL_H */
 
@@ -0,0 +1,28 @@
+/*
+ * file: firmware.c
+ * author: J. van Hooydonk
+ * comments: host build of the firmware (all driver sources in 1 unit)
+ *
+ * the firmware declares (and initialises) its variables in the header files,
+ * so the sources must be compiled as 1 unit against the register shim in
+ * xc.h: each host program includes this file once
+ * main.c is left out, each host program has its own main loop
+ *
+ * revision history:
+ *  v1.0 Creation (16/10/2026)
+ *  v1.1 ISR profiler (16/10/2026)
+ *  v1.2 LN trace (16/10/2026)
+ *  v1.3 latency histograms (16/10/2026)
+ */
+
+#include "MAX7219.c"
+#include "aw.c"
+#include "circular_queue.c"
+#include "eeprom.c"
+#include "general.c"
+#include "latency.c"
+#include "ln.c"
+#include "profiler.c"
+#include "s.c"
+#include "servo.c"
+#include "trace.c"
@@ -0,0 +1,439 @@
+/*
+ * file: ln_msg.c
+ * author: J. van Hooydonk
+ * comments: host helper routines to build and decode LN messages
+ *
+ * revision history:
+ *  v1.0 Creation (16/10/2026)
+ *  v1.1 peer transfer (LN statistics) (16/10/2026)
+ *  v1.2 switch state request and interrogate (16/10/2026)
+ *  v1.3 peer transfer (LN trace) (16/10/2026)
+ *  v1.4 LN message from a line of a capture (16/10/2026)
+ *  v1.5 peer transfer (latency histograms) (16/10/2026)
+ *  v1.6 latency request 0x90 (msb in PXCT1), peer transfer with 8 data
+ *       bytes (16/10/2026)
+ */
+
+#include <ctype.h>
+#include <stdio.h>
+#include "ln_msg.h"
+
+/**
+ * get the length of a LN message (refer to rxHandler in ln.c)
+ * @param msg: the LN message (at least the first 2 bytes)
+ * @return the length of the LN message
+ */
+uint8_t lnMsgLength(const uint8_t* msg)
+{
+    uint8_t length = (uint8_t) (((msg[0] & 0x60) >> 4) + 2);
+
+    if (length > 6)
+    {
+        length = msg[1];
+    }
+    return length;
+}
+
+/**
+ * calculate the checksum and put it in the last byte of the LN message
+ * @param msg: the LN message
+ * @param length: the length of the LN message (with checksum)
+ * @return the length of the LN message
+ */
+uint8_t lnMsgSetChecksum(uint8_t* msg, uint8_t length)
+{
+    uint8_t checksum = 0xff;
+
+    for (uint8_t i = 0; i < length - 1; i++)
+    {
+        checksum ^= msg[i];
+    }
+    msg[length - 1] = checksum;
+    return length;
+}
+
+/**
+ * check the checksum of a LN message
+ * @param msg: the LN message
+ * @param length: the length of the LN message (with checksum)
+ * @return true: if the checksum is correct
+ */
+bool lnMsgIsChecksumCorrect(const uint8_t* msg, uint8_t length)
+{
+    uint8_t checksum = 0x00;
+
+    for (uint8_t i = 0; i < length; i++)
+    {
+        checksum ^= msg[i];
+    }
+    return (checksum == 0xff);
+}
+
+/**
+ * build a global power ON/OFF request (OPC_GPON/OPC_GPOFF)
+ * @param msg: the buffer for the LN message
+ * @param on: true = power ON, false = power OFF
+ * @return the length of the LN message
+ */
+uint8_t lnMsgPower(uint8_t* msg, bool on)
+{
+    msg[0] = on ? 0x83 : 0x82;
+    return lnMsgSetChecksum(msg, 2);
+}
+
+/**
+ * build a switch request (OPC_SW_REQ) for a turnout of a board
+ * @param msg: the buffer for the LN message
+ * @param board: the board address (DIP switches)
+ * @param index: the index of the turnout (0 - 7)
+ * @param dir: true = CAWL, false = CAWR
+ * @return the length of the LN message
+ */
+uint8_t lnMsgSwReq(uint8_t* msg, uint8_t board, uint8_t index, bool dir)
+{
+    uint16_t address = (uint16_t) ((board << 3) + (index & 0x07));
+
+    msg[0] = 0xb0;
+    msg[1] = address & 0x7f;
+    msg[2] = (uint8_t) ((address >> 7) & 0x0f) | 0x10 | (dir ? 0x20 : 0x00);
+    return lnMsgSetChecksum(msg, 4);
+}
+
+/**
+ * build a request for the state of a turnout of a board (OPC_SW_STATE)
+ * @param msg: the buffer for the LN message
+ * @param board: the board address (DIP switches)
+ * @param index: the index of the turnout (0 - 7)
+ * @return the length of the LN message
+ */
+uint8_t lnMsgSwState(uint8_t* msg, uint8_t board, uint8_t index)
+{
+    uint16_t address = (uint16_t) ((board << 3) + (index & 0x07));
+
+    msg[0] = 0xbc;
+    msg[1] = address & 0x7f;
+    msg[2] = (uint8_t) ((address >> 7) & 0x0f);
+    return lnMsgSetChecksum(msg, 4);
+}
+
+/**
+ * build an interrogate (OPC_SW_REQ to the addresses 1017 - 1020, DIR = 1,
+ * ON = 0), a command station sends the 4 addresses in sequence
+ * @param msg: the buffer for the LN message
+ * @param n: the interrogate address (0 - 3)
+ * @return the length of the LN message
+ */
+uint8_t lnMsgInterrogate(uint8_t* msg, uint8_t n)
+{
+    msg[0] = 0xb0;
+    msg[1] = (uint8_t) (0x78 | (n & 0x03));
+    msg[2] = 0x27;
+    return lnMsgSetChecksum(msg, 4);
+}
+
+/**
+ * build an immediate packet (OPC_IMM_PACKET) with a signal aspect
+ * (refer to getAddressFromOpcImmPacket in general.c)
+ * @param msg: the buffer for the LN message
+ * @param board: the board address (DIP switches)
+ * @param index: the index of the signal (0 - 7)
+ * @param aspect: the aspect
+ * @return the length of the LN message
+ */
+uint8_t lnMsgImmAspect(uint8_t* msg, uint8_t board, uint8_t index,
+        uint8_t aspect)
+{
+    uint16_t address = (uint16_t) ((board << 3) + (index & 0x07));
+
+    msg[0] = 0xed;
+    msg[1] = 0x0b;
+    msg[2] = 0x7f;
+    msg[3] = 0x30;
+    msg[4] = 0x21;
+    msg[5] = (uint8_t) ((((address >> 6) & 0x03) << 4) | ((address >> 2) & 0x0f));
+    msg[6] = (uint8_t) (((((address >> 8) & 0x07) ^ 0x07) << 4) |
+            ((address & 0x03) << 1) | 0x01);
+    msg[7] = aspect & 0x7f;
+    msg[8] = 0x00;
+    msg[9] = 0x00;
+    return lnMsgSetChecksum(msg, 11);
+}
+
+/**
+ * build a request for the LN statistics of a board (OPC_PEER_XFER)
+ * (refer to lnStatsHandler in general.c)
+ * @param msg: the buffer for the LN message
+ * @param src: the source (address of the requester)
+ * @param board: the board address (DIP switches)
+ * @param page: the page with the counters
+ * @return the length of the LN message
+ */
+uint8_t lnMsgStatsRequest(uint8_t* msg, uint8_t src, uint8_t board,
+        uint8_t page)
+{
+    msg[0] = 0xe5;
+    msg[1] = 0x10;
+    msg[2] = src & 0x7f;
+    msg[3] = board & 0x7f;
+    msg[4] = (uint8_t) (board >> 7);
+    for (uint8_t i = 5; i < 15; i++)
+    {
+        msg[i] = 0x00;
+    }
+    msg[6] = (uint8_t) (0x10 + (page & 0x0f));
+    return lnMsgSetChecksum(msg, 16);
+}
+
+/**
+ * build a request for the ISR profile of a board (OPC_PEER_XFER), the
+ * board must be built with ISR_PROFILE (refer to lnProfileHandler in
+ * general.c)
+ * @param msg: the buffer for the LN message
+ * @param src: the source (address of the requester)
+ * @param board: the board address (DIP switches)
+ * @param source: the profiled ISR routine (see profileSource_t)
+ * @param page: the page with the values
+ * @return the length of the LN message
+ */
+uint8_t lnMsgProfileRequest(uint8_t* msg, uint8_t src, uint8_t board,
+        uint8_t source, uint8_t page)
+{
+    lnMsgStatsRequest(msg, src, board, 0);
+    msg[6] = (uint8_t) (0x30 + (page & 0x0f));
+    msg[7] = source & 0x7f;
+    return lnMsgSetChecksum(msg, 16);
+}
+
+/**
+ * build a request for a chunk of the LN trace of a board (OPC_PEER_XFER),
+ * the board must be built with LN_TRACE (refer to lnTraceHandler in
+ * general.c)
+ * @param msg: the buffer for the LN message
+ * @param src: the source (address of the requester)
+ * @param board: the board address (DIP switches)
+ * @param chunk: the chunk (chunk 0 freezes the trace, the last chunk or 1s
+ * without a chunk releases it)
+ * @return the length of the LN message
+ */
+uint8_t lnMsgTraceRequest(uint8_t* msg, uint8_t src, uint8_t board,
+        uint8_t chunk)
+{
+    lnMsgStatsRequest(msg, src, board, 0);
+    msg[6] = 0x50;
+    msg[7] = chunk & 0x7f;
+    return lnMsgSetChecksum(msg, 16);
+}
+
+/**
+ * build a request for a page of a latency histogram of a board
+ * (OPC_PEER_XFER), the board must be built with CMD_LATENCY (refer to
+ * lnLatencyHandler in general.c)
+ * @param msg: the buffer for the LN message
+ * @param src: the source (address of the requester)
+ * @param board: the board address (DIP switches)
+ * @param histogram: the histogram (channel * 2 + stage)
+ * @param page: the page with the values
+ * @return the length of the LN message
+ */
+uint8_t lnMsgLatencyRequest(uint8_t* msg, uint8_t src, uint8_t board,
+        uint8_t histogram, uint8_t page)
+{
+    lnMsgStatsRequest(msg, src, board, 0);
+    // D1 = 0x90 + page, the msb is bit 0 of PXCT1
+    msg[5] = 0x01;
+    msg[6] = (uint8_t) (0x10 + (page & 0x0f));
+    msg[7] = histogram & 0x7f;
+    return lnMsgSetChecksum(msg, 16);
+}
+
+/**
+ * build a peer transfer with 8 data bytes (OPC_PEER_XFER), the msb of the
+ * data bytes is moved to PXCT1 and PXCT2 (refer to lnPeerXferHandler in
+ * general.c)
+ * @param msg: the buffer for the LN message
+ * @param src: the source
+ * @param dst: the destination
+ * @param data: the 8 data bytes (D1 - D8)
+ * @return the length of the LN message
+ */
+uint8_t lnMsgPeerXfer(uint8_t* msg, uint8_t src, uint16_t dst,
+        const uint8_t* data)
+{
+    msg[0] = 0xe5;
+    msg[1] = 0x10;
+    msg[2] = src & 0x7f;
+    msg[3] = dst & 0x7f;
+    msg[4] = (uint8_t) ((dst >> 7) & 0x7f);
+    for (uint8_t i = 0; i < 8; i++)
+    {
+        uint8_t pxct = (i < 4) ? 5 : 10;
+        if ((i & 0x03) == 0)
+        {
+            msg[pxct] = 0x00;
+        }
+        msg[pxct] |= (uint8_t) ((data[i] >> 7) << (i & 0x03));
+        msg[(i < 4) ? 6 + i : 7 + i] = data[i] & 0x7f;
+    }
+    return lnMsgSetChecksum(msg, 16);
+}
+
+/**
+ * get the 8 data bytes of a peer transfer (D1 - D8 with their msb from
+ * PXCT1 and PXCT2)
+ * @param data: the buffer for the 8 data bytes
+ * @param msg: the LN message
+ * @param length: the length of the LN message
+ * @return true if the LN message is a peer transfer with 8 data bytes
+ */
+bool lnMsgPeerXferData(uint8_t* data, const uint8_t* msg, uint8_t length)
+{
+    if ((msg[0] != 0xe5) || (length != 16))
+    {
+        return false;
+    }
+    for (uint8_t i = 0; i < 8; i++)
+    {
+        uint8_t pxct = (i < 4) ? msg[5] : msg[10];
+        data[i] = (uint8_t) (msg[(i < 4) ? 6 + i : 7 + i] |
+                (((pxct >> (i & 0x03)) & 0x01) << 7));
+    }
+    return true;
+}
+
+/**
+ * decode a LN message into readable text
+ * @param text: the buffer for the text
+ * @param size: the size of the buffer
+ * @param msg: the LN message
+ * @param length: the length of the LN message
+ */
+void lnMsgFormat(char* text, size_t size, const uint8_t* msg, uint8_t length)
+{
+    int n = 0;
+    uint16_t address = (uint16_t) ((msg[1] & 0x7f) | ((msg[2] & 0x0f) << 7));
+
+    switch (msg[0])
+    {
+        case 0x82:
+            n = snprintf(text, size, "OPC_GPOFF");
+            break;
+        case 0x83:
+            n = snprintf(text, size, "OPC_GPON");
+            break;
+        case 0xb0:
+            n = snprintf(text, size, "OPC_SW_REQ     board %3u index %u %s",
+                    address >> 3, address & 0x07,
+                    (msg[2] & 0x20) ? "CAWL" : "CAWR");
+            break;
+        case 0xb1:
+            n = snprintf(text, size, "OPC_SW_REP     board %3u index %u%s%s",
+                    address >> 3, address & 0x07,
+                    (msg[2] & 0x20) ? " KAWL" : "",
+                    (msg[2] & 0x10) ? " KAWR" : "");
+            break;
+        case 0xb2:
+            n = snprintf(text, size, "OPC_INPUT_REP  board %3u index %u %s",
+                    address >> 3, address & 0x07,
+                    (msg[2] & 0x10) ? "KFS" : "-");
+            break;
+        case 0xb4:
+            n = snprintf(text, size, "OPC_LONG_ACK   lopc 0x%02x ack1 0x%02x",
+                    msg[1], msg[2]);
+            break;
+        case 0xbc:
+            n = snprintf(text, size, "OPC_SW_STATE   board %3u index %u",
+                    address >> 3, address & 0x07);
+            break;
+        case 0xed:
+            n = snprintf(text, size, "OPC_IMM_PACKET IM1 0x%02x IM2 0x%02x "
+                    "aspect %u", msg[5], msg[6], msg[7]);
+            break;
+        case 0xe5:
+        {
+            uint8_t d[8];
+            bool data = lnMsgPeerXferData(d, msg, length);
+            if (data && ((d[0] & 0xf0) == 0x20))
+            {
+                n = snprintf(text, size, "OPC_PEER_XFER  src %3u dst %3u "
+                        "stats page %u: %u %u %u", msg[2], msg[3], d[0] & 0x0f,
+                        d[1] | (d[2] << 8), d[3] | (d[4] << 8),
+                        d[5] | (d[6] << 8));
+            }
+            else if (data && ((d[0] & 0xf0) == 0x40))
+            {
+                n = snprintf(text, size, "OPC_PEER_XFER  src %3u dst %3u "
+                        "profile %u page %u: %u %u %u", msg[2], msg[3], d[7],
+                        d[0] & 0x0f, d[1] | (d[2] << 8), d[3] | (d[4] << 8),
+                        d[5] | (d[6] << 8));
+            }
+            else if (data && ((d[0] & 0xe0) == 0x60))
+            {
+                n = snprintf(text, size, "OPC_PEER_XFER  src %3u dst %3u "
+                        "trace chunk %u", msg[2], msg[3], d[0] & 0x1f);
+            }
+            else if (data && ((d[0] & 0xf0) == 0x80))
+            {
+                n = snprintf(text, size, "OPC_PEER_XFER  src %3u dst %3u "
+                        "latency %u page %u: %u %u %u", msg[2], msg[3], d[7],
+                        d[0] & 0x0f, d[1] | (d[2] << 8), d[3] | (d[4] << 8),
+                        d[5] | (d[6] << 8));
+            }
+            else
+            {
+                n = snprintf(text, size, "OPC_PEER_XFER  src %3u dst %3u",
+                        msg[2], msg[3] | (msg[4] << 7));
+            }
+            break;
+        }
+        default:
+            n = snprintf(text, size, "opcode 0x%02x", msg[0]);
+            break;
+    }
+    for (uint8_t i = 0; (i < length) && (n > 0) && ((size_t) n < size); i++)
+    {
+        n += snprintf(text + n, size - (size_t) n, "%s%02x",
+                (i == 0) ? "  [" : " ", msg[i]);
+    }
+    if ((n > 0) && ((size_t) n < size))
+    {
+        snprintf(text + n, size - (size_t) n, "]");
+    }
+}
+
+/**
+ * get the bytes of a LN message from a line of a capture (text with the LN
+ * message in hex, like a LN monitor), the bytes start after '[' (as printed
+ * by lnsim and the JMRI monitor) or at the begin of the line
+ * @param msg: the buffer for the LN message
+ * @param line: the line
+ * @return the number of bytes (0 if the line has no LN message)
+ */
+uint8_t lnMsgParse(uint8_t* msg, const char* line)
+{
+    const char* p = line;
+    uint8_t length = 0;
+
+    while (*p && (*p != '['))
+    {
+        p++;
+    }
+    p = *p ? p + 1 : line;
+    while (length < LN_MSG_MAX)
+    {
+        while ((*p == ' ') || (*p == '\t'))
+        {
+            p++;
+        }
+        if (!isxdigit((unsigned char) p[0]) ||
+                !isxdigit((unsigned char) p[1]) ||
+                isxdigit((unsigned char) p[2]))
+        {
+            break;
+        }
+        unsigned value;
+        sscanf(p, "%2x", &value);
+        msg[length++] = (uint8_t) value;
+        p += 2;
+    }
+    return length;
+}
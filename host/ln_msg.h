@@ -0,0 +1,47 @@
+/*
+ * file: ln_msg.h
+ * author: J. van Hooydonk
+ * comments: host helper routines to build and decode LN messages
+ *
+ * revision history:
+ *  v1.0 Creation (16/10/2026)
+ *  v1.1 peer transfer (LN statistics) (16/10/2026)
+ *  v1.2 peer transfer (ISR profile) (16/10/2026)
+ *  v1.3 switch state request and interrogate (16/10/2026)
+ *  v1.4 peer transfer (LN trace) (16/10/2026)
+ *  v1.5 LN message from a line of a capture (16/10/2026)
+ *  v1.6 peer transfer (latency histograms) (16/10/2026)
+ *  v1.7 peer transfer with 8 data bytes (16/10/2026)
+ */
+
+// this is a guard condition so that contents of this file are not included
+// more than once
+#ifndef LN_MSG_H
+#define	LN_MSG_H
+
+#include <stdbool.h>
+#include <stddef.h>
+#include <stdint.h>
+
+// definitions
+#define LN_MSG_MAX 128U             // maximum length of a LN message
+
+// routines
+uint8_t lnMsgLength(const uint8_t*);
+uint8_t lnMsgSetChecksum(uint8_t*, uint8_t);
+bool lnMsgIsChecksumCorrect(const uint8_t*, uint8_t);
+uint8_t lnMsgPower(uint8_t*, bool);
+uint8_t lnMsgSwReq(uint8_t*, uint8_t, uint8_t, bool);
+uint8_t lnMsgSwState(uint8_t*, uint8_t, uint8_t);
+uint8_t lnMsgInterrogate(uint8_t*, uint8_t);
+uint8_t lnMsgImmAspect(uint8_t*, uint8_t, uint8_t, uint8_t);
+uint8_t lnMsgStatsRequest(uint8_t*, uint8_t, uint8_t, uint8_t);
+uint8_t lnMsgProfileRequest(uint8_t*, uint8_t, uint8_t, uint8_t, uint8_t);
+uint8_t lnMsgTraceRequest(uint8_t*, uint8_t, uint8_t, uint8_t);
+uint8_t lnMsgLatencyRequest(uint8_t*, uint8_t, uint8_t, uint8_t, uint8_t);
+uint8_t lnMsgPeerXfer(uint8_t*, uint8_t, uint16_t, const uint8_t*);
+bool lnMsgPeerXferData(uint8_t*, const uint8_t*, uint8_t);
+void lnMsgFormat(char*, size_t, const uint8_t*, uint8_t);
+uint8_t lnMsgParse(uint8_t*, const char*);
+
+#endif	/* LN_MSG_H */
@@ -0,0 +1,565 @@
+/*
+ * file: lnbench.c
+ * author: J. van Hooydonk
+ * comments: host program, microbenchmarks of the per-tick and per-byte
+ *           routines of the firmware
+ *
+ * usage: lnbench [-f filter] [-c baseline] [-r percent]
+ *  -f: only run the benchmarks whose name contains the filter
+ *  -c: compare with a previous output of lnbench (the baseline) and fail
+ *      when a benchmark is slower than the baseline
+ *  -r: the allowed regression in percent (default 25)
+ *
+ * every line of the output gives the name of the benchmark, the time per
+ * operation (ns/op) and the number of operations in 1 call (ops/call)
+ * the inputs are fixed, so the results of 2 runs can be compared
+ * the times are measured on the host (not on the PIC), they are meant to
+ * compare 2 revisions of the firmware, not to check the ISR budget
+ *
+ * revision history:
+ *  v1.0 Creation (16/10/2026)
+ */
+
+#define _POSIX_C_SOURCE 200809L
+
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <time.h>
+#include <unistd.h>
+#include "firmware.c"
+#include "pic18_sim.h"
+#include "ln_msg.h"
+
+// definitions
+#define BENCH_BATCH 256U            // number of calls between 2 setups
+#define BENCH_TIME 20000000U        // minimum measuring time (ns)
+#define BENCH_MAX 128U              // maximum number of benchmark results
+#define BENCH_ADDRESS 1U            // DIP switch address of the board
+
+// benchmark definition (as function pointers)
+typedef void (*benchSetup_t)(uint16_t);
+typedef void (*benchRun_t)(uint16_t);
+
+typedef struct {
+    char name[48];
+    double nsPerOp;
+    unsigned opsPerCall;
+} benchResult_t;
+
+// variables
+static benchResult_t results[BENCH_MAX];
+static uint8_t resultCount;
+static const char* filter;
+static volatile uint32_t sink;
+
+// LN receive stream: a mix of messages for this board, for other boards
+// and messages that are not handled (slot data, peer transfer)
+static uint8_t rxStream[512];
+static uint16_t rxStreamLength;
+static uint8_t rxMsg[8][LN_MSG_MAX];
+static uint8_t rxMsgLength[8];
+static const char* rxMsgName[8];
+// LN bus stream: messages that the board does not handle (slot data, speed,
+// sensor and turnout reports of other boards)
+static uint8_t busStream[512];
+static uint16_t busStreamLength;
+
+// <editor-fold defaultstate="collapsed" desc="measurement">
+
+/**
+ * get the monotonic time
+ * @return the time in ns
+ */
+static uint64_t nowNs(void)
+{
+    struct timespec ts;
+
+    clock_gettime(CLOCK_MONOTONIC, &ts);
+    return (uint64_t) ts.tv_sec * 1000000000U + (uint64_t) ts.tv_nsec;
+}
+
+/**
+ * run a benchmark: the setup is called (not measured) before every batch
+ * of calls, the batches are repeated until the minimum time has passed and
+ * the fastest batch is taken (this filters out the noise of the host)
+ * @param name: the name of the benchmark
+ * @param setup: the setup routine (or 0)
+ * @param run: the measured routine (called with the call index)
+ * @param param: the parameter for the setup routine
+ * @param opsPerCall: the number of operations in 1 call
+ */
+static void bench(const char* name, benchSetup_t setup, benchRun_t run,
+        uint16_t param, unsigned opsPerCall)
+{
+    uint64_t total = 0;
+    uint64_t fastest = UINT64_MAX;
+
+    if ((filter != 0) && (strstr(name, filter) == 0))
+    {
+        return;
+    }
+    while (total < BENCH_TIME)
+    {
+        if (setup != 0)
+        {
+            (*setup)(param);
+        }
+        uint64_t start = nowNs();
+        for (uint16_t i = 0; i < BENCH_BATCH; i++)
+        {
+            (*run)(i);
+        }
+        uint64_t time = nowNs() - start;
+
+        fastest = (time < fastest) ? time : fastest;
+        total += time;
+    }
+    if (resultCount < BENCH_MAX)
+    {
+        benchResult_t* result = &results[resultCount++];
+
+        snprintf(result->name, sizeof (result->name), "%s", name);
+        result->nsPerOp = (double) fastest /
+                (double) (BENCH_BATCH * opsPerCall);
+        result->opsPerCall = opsPerCall;
+        printf("%-40s %10.2f %10u\n", result->name, result->nsPerOp,
+                opsPerCall);
+    }
+}
+
+/**
+ * compare the results with a baseline (a previous output of lnbench)
+ * @param fileName: the name of the baseline file
+ * @param percent: the allowed regression in percent
+ * @return the number of benchmarks that are slower than allowed
+ */
+static int compareBaseline(const char* fileName, double percent)
+{
+    FILE* file = fopen(fileName, "r");
+    char line[160];
+    int failed = 0;
+
+    if (file == 0)
+    {
+        fprintf(stderr, "cannot open baseline %s\n", fileName);
+        return 1;
+    }
+    printf("\n%-40s %10s %10s %8s\n", "compared to baseline", "base", "now",
+            "change");
+    while (fgets(line, sizeof (line), file) != 0)
+    {
+        char name[48];
+        double base;
+        unsigned ops;
+
+        if (sscanf(line, "%47s %lf %u", name, &base, &ops) != 3)
+        {
+            continue;
+        }
+        for (uint8_t i = 0; i < resultCount; i++)
+        {
+            if (strcmp(results[i].name, name) == 0)
+            {
+                double change = (results[i].nsPerOp - base) * 100.0 / base;
+                bool slower = change > percent;
+
+                printf("%-40s %10.2f %10.2f %+7.1f%%%s\n", name, base,
+                        results[i].nsPerOp, change, slower ? "  SLOWER" : "");
+                failed += slower ? 1 : 0;
+            }
+        }
+    }
+    fclose(file);
+    return failed;
+}
+
+// </editor-fold>
+
+// <editor-fold defaultstate="collapsed" desc="inputs">
+
+/**
+ * add a LN message to the receive stream
+ * @param msg: the LN message
+ * @param length: the length of the LN message
+ * @param name: the name of the LN message (or 0)
+ */
+static void addRxMessage(const uint8_t* msg, uint8_t length, const char* name)
+{
+    static uint8_t count;
+
+    memcpy(&rxStream[rxStreamLength], msg, length);
+    rxStreamLength += length;
+    if ((name != 0) && (count < 8))
+    {
+        memcpy(rxMsg[count], msg, length);
+        rxMsgLength[count] = length;
+        rxMsgName[count] = name;
+        count++;
+    }
+}
+
+/**
+ * build the (fixed) LN receive stream
+ */
+static void buildRxStream(void)
+{
+    uint8_t msg[LN_MSG_MAX];
+    // OPC_SL_RD_DATA (14 bytes) and OPC_PEER_XFER (16 bytes)
+    uint8_t slot[14] = {0xe7, 0x0e, 0x05, 0x03, 0x12, 0x00, 0x00, 0x07,
+        0x00, 0x00, 0x00, 0x00, 0x00, 0x00};
+    uint8_t peer[16] = {0xe5, 0x10, 0x7f, 0x00, 0x00, 0x00, 0x01, 0x02,
+        0x03, 0x04, 0x00, 0x05, 0x06, 0x07, 0x08, 0x00};
+
+    addRxMessage(msg, lnMsgSwReq(msg, BENCH_ADDRESS, 2, true),
+            "OPC_SW_REQ(board)");
+    addRxMessage(msg, lnMsgSwReq(msg, BENCH_ADDRESS + 1, 2, true),
+            "OPC_SW_REQ(other)");
+    addRxMessage(msg, lnMsgImmAspect(msg, BENCH_ADDRESS, 3, 0),
+            "OPC_IMM_PACKET(board)");
+    addRxMessage(msg, lnMsgImmAspect(msg, BENCH_ADDRESS + 1, 3, 2),
+            "OPC_IMM_PACKET(other)");
+    addRxMessage(msg, lnMsgPower(msg, true), "OPC_GPON");
+    addRxMessage(msg, lnMsgPower(msg, false), "OPC_GPOFF");
+    addRxMessage(slot, lnMsgSetChecksum(slot, sizeof (slot)),
+            "OPC_SL_RD_DATA");
+    addRxMessage(peer, lnMsgSetChecksum(peer, sizeof (peer)),
+            "OPC_PEER_XFER");
+    for (uint8_t i = 0; i < 8; i++)
+    {
+        addRxMessage(msg, lnMsgSwReq(msg, (uint8_t) (BENCH_ADDRESS + i), i,
+                (i & 1) == 0), 0);
+        addRxMessage(msg, lnMsgImmAspect(msg, (uint8_t) (BENCH_ADDRESS + i),
+                i, (uint8_t) (i + 1)), 0);
+    }
+    addRxMessage(peer, sizeof (peer), 0);
+    addRxMessage(slot, sizeof (slot), 0);
+
+    // OPC_LOCO_SPD, OPC_INPUT_REP and OPC_SW_REP (4 bytes)
+    uint8_t speed[4] = {0xa0, 0x03, 0x40, 0x00};
+    uint8_t input[4] = {0xb2, 0x12, 0x51, 0x00};
+    uint8_t report[4] = {0xb1, 0x22, 0x31, 0x00};
+    lnMsgSetChecksum(speed, sizeof (speed));
+    lnMsgSetChecksum(input, sizeof (input));
+    lnMsgSetChecksum(report, sizeof (report));
+    while (busStreamLength + sizeof (slot) + 3 * 4 <= sizeof (busStream))
+    {
+        memcpy(&busStream[busStreamLength], slot, sizeof (slot));
+        busStreamLength += sizeof (slot);
+        memcpy(&busStream[busStreamLength], speed, sizeof (speed));
+        busStreamLength += sizeof (speed);
+        memcpy(&busStream[busStreamLength], input, sizeof (input));
+        busStreamLength += sizeof (input);
+        memcpy(&busStream[busStreamLength], report, sizeof (report));
+        busStreamLength += sizeof (report);
+    }
+}
+
+/**
+ * set the content of a queue without the queue routines
+ * @param queue: the queue
+ * @param data: the data (or 0 to keep the content)
+ * @param length: the number of entries
+ */
+static void setQueue(lnQueue_t* queue, const uint8_t* data, uint8_t length)
+{
+    if (data != 0)
+    {
+        memcpy(queue->values, data, length);
+    }
+    queue->head = 0;
+    queue->numEntries = length;
+    queue->tail = (uint8_t) (length & queue->mask);
+}
+
+/**
+ * discard the LN messages the firmware has transmitted (reports)
+ */
+static void clearTx(void)
+{
+    for (uint8_t i = 0; i < LN_TX_PRIORITIES; i++)
+    {
+        initQueue(&lnTxQueue[i], lnTxQueueValues[i], LN_TX_QUEUE_SIZE);
+    }
+}
+
+// </editor-fold>
+
+// <editor-fold defaultstate="collapsed" desc="benchmarks">
+
+static lnQueue_t queue;
+static uint8_t queueValues[QUEUE_SIZE];
+static uint8_t param;
+
+static void setupEmptyQueue(uint16_t p)
+{
+    initQueue(&queue, queueValues, QUEUE_SIZE);
+}
+
+static void setupFullQueue(uint16_t p)
+{
+    setQueue(&queue, 0, QUEUE_SIZE);
+}
+
+static void runEnQueue(uint16_t i)
+{
+    if (isQueueFull(&queue))
+    {
+        initQueue(&queue, queueValues, QUEUE_SIZE);
+    }
+    enQueue(&queue, (uint8_t) i);
+}
+
+static void runDeQueue(uint16_t i)
+{
+    if (isQueueEmpty(&queue))
+    {
+        setQueue(&queue, 0, QUEUE_SIZE);
+    }
+    deQueue(&queue);
+}
+
+static void runEnDeQueue(uint16_t i)
+{
+    enQueue(&queue, (uint8_t) i);
+    deQueue(&queue);
+}
+
+static void runClearQueue(uint16_t i)
+{
+    setQueue(&queue, 0, QUEUE_SIZE);
+    clearQueue(&queue);
+}
+
+static void runEnDeQueueSpan(uint16_t i)
+{
+    static uint8_t data[4] = {0xb0, 0x01, 0x20, 0x6e};
+
+    enQueueSpan(&queue, data, sizeof (data));
+    deQueueSpan(&queue, sizeof (data));
+}
+
+static void setupTx(uint16_t p)
+{
+    clearTx();
+}
+
+static void runTxReportHandler(uint16_t i)
+{
+    static uint8_t data[4] = {0xb1, 0x01, 0x30, 0xff ^ 0xb1 ^ 0x01 ^ 0x30};
+
+    // the first report is added, the next ones overwrite it
+    lnTxReportHandler(data, sizeof (data), LN_TX_PRIO_HIGH);
+}
+
+static void runTxMessageHandler(uint16_t i)
+{
+    static uint8_t data[4] = {0xb1, 0x01, 0x30, 0xff ^ 0xb1 ^ 0x01 ^ 0x30};
+
+    if (lnTxMessageHandler(data, sizeof (data), LN_TX_PRIO_HIGH) ==
+            LN_TX_FULL)
+    {
+        clearQueue(&lnTxQueue[LN_TX_PRIO_HIGH]);
+    }
+}
+
+static void setupRx(uint16_t p)
+{
+    clearTx();
+    lnRxRing.head = 0;
+    lnRxRing.tail = 0;
+    lnRxRing.slots[0].length = 0;
+}
+
+static void runRxHandler(uint16_t i)
+{
+    for (uint16_t j = 0; j < rxStreamLength; j++)
+    {
+        rxHandler(rxStream[j]);
+        // the main loop handles the complete LN messages (LN_RX_IN_MAIN)
+        lnRxRingHandler();
+    }
+}
+
+static void runRxHandlerBus(uint16_t i)
+{
+    for (uint16_t j = 0; j < busStreamLength; j++)
+    {
+        rxHandler(busStream[j]);
+        lnRxRingHandler();
+    }
+}
+
+static void runChecksum(uint16_t i)
+{
+    sink += isChecksumCorrect(rxMsg[7], rxMsgLength[7]);
+}
+
+static void runRxOpcodeHandler(uint16_t i)
+{
+    uint8_t entry = getLnRxOpcodeEntry(rxMsg[param][0]);
+
+    if (entry != LN_RX_SKIP)
+    {
+        (*lnRxOpcodes[entry].handler)(rxMsg[param], rxMsgLength[param]);
+    }
+}
+
+static void setupAspect(uint16_t aspect)
+{
+    clearTx();
+    sList[0].CVT_mode = (aspect >= ASPECT_MODES);
+    sList[0].aspect = (uint8_t) (aspect % ASPECT_MODES);
+}
+
+static void runSetIntensity(uint16_t i)
+{
+    setIntensity(0);
+}
+
+static void runSetIntensityMainPanel(uint16_t i)
+{
+    // subtractor for the aspect (refer to setIntensity)
+    static const uint8_t subtractor[ASPECT_MODES] = {
+        0, 0, 0, 0, 0, 0, 4, 4, 4, 4, 8, 8, 8, 8, 12, 12, 12, 12
+    };
+    setIntensityMainPanel(0, subtractor[sList[0].aspect]);
+}
+
+static void runIsAspectValid(uint16_t i)
+{
+    uint32_t valid = 0;
+
+    for (uint8_t oldAspect = 0; oldAspect < ASPECT_MODES; oldAspect++)
+    {
+        for (uint8_t newAspect = 0; newAspect < ASPECT_MODES; newAspect++)
+        {
+            valid += isAspectValid(oldAspect, newAspect);
+        }
+    }
+    sink += valid;
+}
+
+static void runSIsrTmr3(uint16_t i)
+{
+    sIsrTmr3();
+}
+
+static void setupServo(uint16_t mode)
+{
+    clearTx();
+    // mode 0: CAWL = CAWR (middle), mode 1: CAWL, mode 2: CAWR
+    awList[0].CAWL = (mode == 1);
+    awList[0].CAWR = (mode == 2);
+    servoPortD[0] = 1500U;
+}
+
+static void runAwUpdateServo(uint16_t i)
+{
+    if ((i & 0x3f) == 0)
+    {
+        // restart the sweep, so the servo keeps moving
+        servoPortD[0] = 1500U;
+    }
+    awUpdateServo(&servoPortD[0], 0);
+}
+
+static void runUpdateLeds(uint16_t i)
+{
+    updateLeds();
+}
+
+// </editor-fold>
+
+/**
+ * main (start of program)
+ */
+int main(int argc, char** argv)
+{
+    const char* baseline = 0;
+    double percent = 25.0;
+    char name[48];
+    int option;
+
+    while ((option = getopt(argc, argv, "f:c:r:")) != -1)
+    {
+        switch (option)
+        {
+            case 'f':
+                filter = optarg;
+                break;
+            case 'c':
+                baseline = optarg;
+                break;
+            case 'r':
+                percent = strtod(optarg, 0);
+                break;
+            default:
+                fprintf(stderr, "usage: %s [-f filter] [-c baseline] "
+                        "[-r percent]\n", argv[0]);
+                return 1;
+        }
+    }
+
+    // power up the board (the benchmarks run without the simulated clock)
+    simReset();
+    simSetDipAddress(BENCH_ADDRESS);
+    init();
+    buildRxStream();
+
+    printf("%-40s %10s %10s\n", "benchmark", "ns/op", "ops/call");
+
+    // circular queue
+    bench("enQueue", &setupEmptyQueue, &runEnQueue, 0, 1);
+    bench("deQueue", &setupFullQueue, &runDeQueue, 0, 1);
+    bench("enQueue+deQueue", &setupEmptyQueue, &runEnDeQueue, 0, 1);
+    bench("clearQueue(128)", 0, &runClearQueue, 0, 1);
+    bench("enQueueSpan+deQueueSpan(4_bytes)", &setupEmptyQueue,
+            &runEnDeQueueSpan, 0, 1);
+
+    // LN transmitter
+    bench("lnTxMessageHandler(SW_REP)", &setupTx, &runTxMessageHandler,
+            0, 1);
+    bench("lnTxReportHandler(SW_REP,coalesced)", &setupTx,
+            &runTxReportHandler, 0, 1);
+
+    // LN receiver
+    bench("rxHandler(per_byte)", &setupRx, &runRxHandler, 0, rxStreamLength);
+    bench("rxHandler(per_byte,other_traffic)", &setupRx, &runRxHandlerBus, 0,
+            busStreamLength);
+    bench("isChecksumCorrect(16_bytes)", 0, &runChecksum, 0, 1);
+    for (param = 0; param < 8; param++)
+    {
+        snprintf(name, sizeof (name), "lnRxOpcodes[%s]",
+                rxMsgName[param]);
+        bench(name, &setupRx, &runRxOpcodeHandler, 0, 1);
+    }
+
+    // signals
+    for (uint16_t aspect = 0; aspect < ASPECT_MODES * 2; aspect++)
+    {
+        snprintf(name, sizeof (name), "setIntensity[%u%s]",
+                aspect % ASPECT_MODES, (aspect >= ASPECT_MODES) ? ",CVT" : "");
+        bench(name, &setupAspect, &runSetIntensity, aspect, 1);
+    }
+    for (uint16_t aspect = 0; aspect < ASPECT_MODES; aspect++)
+    {
+        snprintf(name, sizeof (name), "setIntensityMainPanel[%u]", aspect);
+        bench(name, &setupAspect, &runSetIntensityMainPanel, aspect, 1);
+    }
+    bench("isAspectValid(18x18)", 0, &runIsAspectValid, 0,
+            ASPECT_MODES * ASPECT_MODES);
+    bench("sIsrTmr3", &setupAspect, &runSIsrTmr3, 2, 1);
+
+    // turnouts and leds
+    bench("awUpdateServo[middle]", &setupServo, &runAwUpdateServo, 0, 1);
+    bench("awUpdateServo[CAWL]", &setupServo, &runAwUpdateServo, 1, 1);
+    bench("awUpdateServo[CAWR]", &setupServo, &runAwUpdateServo, 2, 1);
+    bench("updateLeds", 0, &runUpdateLeds, 0, 1);
+
+    if (baseline != 0)
+    {
+        return (compareBaseline(baseline, percent) == 0) ? 0 : 1;
+    }
+    return 0;
+}
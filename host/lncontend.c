@@ -0,0 +1,866 @@
+/*
+ * file: lncontend.c
+ * author: J. van Hooydonk
+ * comments: host program, contention simulator: N boards with the firmware
+ * (the LN driver of ln.c) transmit on 1 shared LN line
+ *
+ * usage: lncontend [-n nodes] [-t seconds] [-l load] [-p fraction] [-w ms]
+ *                  [-s seed] [-v] [-L lnnode.so]
+ *  -n: the number of nodes, with DIP switch address 0 .. n - 1 (default 8,
+ *      max. 64)
+ *  -t: the virtual time of the measurement in s (default 10)
+ *  -l: the offered load of all nodes together, as a fraction of the line
+ *      rate (1666 bytes/s), default 0.3
+ *  -p: the fraction of the LN messages with high priority (default 0)
+ *  -w: the starvation threshold in ms (default 1000)
+ *  -s: the seed of the load generator (default 1)
+ *  -v: print the results per node
+ *  -L: the shared object of the node (default lnnode.so next to lncontend)
+ *
+ * every node is a separate copy of lnnode.so (the firmware on the simulated
+ * device, see lnnode.h) with its own variables, all nodes are connected to
+ * the LN line of this program (simSetLine)
+ * the line is a wired-AND on bit level: a byte is a frame of 10 bits of
+ * 60us (start bit = 0, 8 data bits lsb first, stop bit = 1), the line is 0
+ * as soon as 1 node drives a 0 (a bit of its frame or a linebreak)
+ * the receiver is the same for all nodes (the propagation delay is not
+ * modelled): it starts at a falling edge, samples the line in the middle of
+ * every bit and has a framing error if the stop bit is 0, then it waits for
+ * the next falling edge (a line that stays 0 gives 1 framing error)
+ * the line is busy for the nodes (RCIDL = 0) from the middle of the start
+ * bit till the stop bit or as long as it stays 0, so the collision window
+ * is half a bit (30us)
+ * the nodes run in lockstep on the virtual clock, always till the next event
+ * of a node, the line or the load generator, the ISR routines run at the
+ * time of their event (every ISR routine takes SIM_ISR_CYCLES, so a node can
+ * be a few us ahead of the others, a byte it starts then is put on the line
+ * at the time of the line)
+ *
+ * the load: every node gets LN messages at random times (Poisson process),
+ * OPC_INPUT_REP with IN1 = sequence number and IN2 = node, that are added
+ * to its LN TX queue (lnTxMessageHandler)
+ * the report: the throughput (delivered LN messages and the fraction of the
+ * line rate), the collisions (per transmit attempt of the firmware, bytes
+ * with more than 1 transmitter, linebreaks), the latency from
+ * lnTxMessageHandler till the end of the LN message on the line
+ * (percentiles per priority class) and the starvation (LN messages that
+ * waited longer than the threshold, or still wait at the end)
+ *
+ * revision history:
+ *  v1.0 Creation (16/10/2026)
+ */
+
+#define _POSIX_C_SOURCE 200809L
+
+#include <dlfcn.h>
+#include <math.h>
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <unistd.h>
+#include "lnnode.h"
+#include "ln_msg.h"
+
+// definitions
+#define MAX_NODES 64U
+#define BIT_CYCLES SIM_US(60)
+#define FRAME_CYCLES (10U * BIT_CYCLES)
+#define LN_BYTES_PER_S 1666.6
+// the LN messages of the load (OPC_INPUT_REP)
+#define LOAD_OPCODE 0xb2
+#define LOAD_LENGTH 4U
+#define SEQUENCES 128U
+// the boards are powered up before the load starts
+#define WARMUP SIM_MS(500)
+// the LN statistics of the firmware are 16 bit, collect them every second
+#define STATS_INTERVAL SIM_MS(1000)
+
+// a node
+
+typedef struct {
+    const lnNode_t* api;
+    simLine_t line;
+    uint8_t address;
+    // the next event of the node (updated when the node has changed)
+    uint64_t next;
+    bool changed;
+    // the byte of the node on the line
+    bool frameActive;
+    uint64_t frameStart;
+    uint8_t frameValue;
+    bool lineBreak;
+    // the load generator
+    uint64_t nextArrival;
+    uint8_t sequence;
+    bool pending[SEQUENCES];
+    bool pendingHigh[SEQUENCES];
+    uint64_t sentAt[SEQUENCES];
+    // results
+    unsigned long offered;
+    unsigned long rejected;
+    unsigned long delivered;
+    unsigned long starved;
+    uint64_t totalLatency;
+    uint64_t maxLatency;
+    lnNodeStats_t stats;
+} node_t;
+
+// the LN line and its receiver
+
+typedef struct {
+    uint64_t now;
+    bool level;
+    bool idle;
+    unsigned breaks;
+    // receiver
+    bool receiving;
+    uint64_t rxStart;
+    uint8_t rxBit;
+    uint8_t rxValue;
+    uint64_t rxDrivers;
+    // LN message on the line
+    uint8_t msg[LN_MSG_MAX];
+    uint8_t msgLength;
+    // results
+    unsigned long bytes;
+    unsigned long sharedBytes;
+    unsigned long framingErrors;
+    unsigned long linebreaks;
+    unsigned long messages;
+    unsigned long checksumErrors;
+} line_t;
+
+// latencies of a priority class
+
+typedef struct {
+    uint64_t* values;
+    size_t count;
+    size_t size;
+} latencies_t;
+
+// variables
+static node_t nodes[MAX_NODES];
+static unsigned nodeCount = 8;
+static line_t line;
+static latencies_t latencies[2];
+static uint64_t starvation;
+static uint64_t randomState;
+
+// <editor-fold defaultstate="collapsed" desc="load generator">
+
+/**
+ * get a random value (xorshift64*)
+ * @return the value (0 < value <= 1)
+ */
+static double getRandom(void)
+{
+    randomState ^= randomState >> 12;
+    randomState ^= randomState << 25;
+    randomState ^= randomState >> 27;
+    uint64_t value = (randomState * 0x2545f4914f6cdd1dULL) >> 11;
+    return (double) (value + 1) / 9007199254740992.0;
+}
+
+/**
+ * get the time till the next LN message of a node (Poisson process)
+ * @param rate: the LN messages per s of the node
+ * @return the time (in cycles)
+ */
+static uint64_t getInterval(double rate)
+{
+    return (uint64_t) (-log(getRandom()) / rate * (double) SIM_MS(1000)) + 1;
+}
+
+/**
+ * add the next LN message of the load to the LN TX queue of a node
+ * @param node: the node
+ * @param time: the time
+ * @param high: the fraction of the LN messages with high priority
+ */
+static void sendLoad(node_t* node, uint64_t time, double high)
+{
+    uint8_t sequence = node->sequence;
+    bool isHigh = getRandom() <= high;
+    uint8_t msg[LOAD_LENGTH] = {LOAD_OPCODE, sequence, node->address, 0};
+
+    msg[3] = (uint8_t) (0xff ^ msg[0] ^ msg[1] ^ msg[2]);
+    node->offered++;
+    // the sequence numbers are in use (or the LN TX queue is full)
+    if (node->pending[sequence] || !(*node->api->send)(msg, LOAD_LENGTH,
+            isHigh))
+    {
+        node->rejected++;
+        return;
+    }
+    node->pending[sequence] = true;
+    node->pendingHigh[sequence] = isHigh;
+    node->sentAt[sequence] = time;
+    node->sequence = (uint8_t) ((sequence + 1) % SEQUENCES);
+}
+
+/**
+ * keep the latency of a delivered LN message
+ * @param node: the node
+ * @param sequence: the sequence number of the LN message
+ * @param time: the end of the LN message on the line
+ */
+static void deliverLoad(node_t* node, uint8_t sequence, uint64_t time)
+{
+    if (!node->pending[sequence])
+    {
+        return;
+    }
+    node->pending[sequence] = false;
+    uint64_t latency = time - node->sentAt[sequence];
+    latencies_t* list = &latencies[node->pendingHigh[sequence] ? 0 : 1];
+    if (list->count == list->size)
+    {
+        list->size = list->size ? list->size * 2 : 4096;
+        list->values = realloc(list->values, list->size * sizeof (uint64_t));
+        if (!list->values)
+        {
+            fprintf(stderr, "lncontend: out of memory\n");
+            exit(1);
+        }
+    }
+    list->values[list->count++] = latency;
+    node->delivered++;
+    node->totalLatency += latency;
+    if (latency > node->maxLatency)
+    {
+        node->maxLatency = latency;
+    }
+    if (latency > starvation)
+    {
+        node->starved++;
+    }
+}
+
+// </editor-fold>
+
+// <editor-fold defaultstate="collapsed" desc="LN line">
+
+/**
+ * check if a node drives the line
+ * @param node: the node
+ * @param time: the time
+ * @return true: if the node transmits a byte or a linebreak
+ */
+static bool isDriving(node_t* node, uint64_t time)
+{
+    return node->lineBreak || (node->frameActive &&
+            (time >= node->frameStart) &&
+            (time < node->frameStart + FRAME_CYCLES));
+}
+
+/**
+ * get the level of the line (wired-AND of all nodes)
+ * @param time: the time
+ * @param drivers: the nodes that drive the line (1 bit per node)
+ * @return the level (true = 1, idle)
+ */
+static bool getLevel(uint64_t time, uint64_t* drivers)
+{
+    bool level = true;
+
+    *drivers = 0;
+    for (unsigned i = 0; i < nodeCount; i++)
+    {
+        node_t* node = &nodes[i];
+        if (!isDriving(node, time))
+        {
+            continue;
+        }
+        *drivers |= 1ULL << i;
+        unsigned bit = node->lineBreak ? 0 :
+                (unsigned) ((time - node->frameStart) / BIT_CYCLES);
+        // start bit = 0, data bits (lsb first), stop bit = 1
+        if ((bit == 0) || ((bit <= 8) &&
+                !((node->frameValue >> (bit - 1)) & 0x01)))
+        {
+            level = false;
+        }
+    }
+    return level;
+}
+
+/**
+ * get the time of the next event of the line
+ * @return the time (UINT64_MAX if the line has no event)
+ */
+static uint64_t getLineEvent(void)
+{
+    if (line.receiving)
+    {
+        // the middle of the next bit
+        return line.rxStart + (line.rxBit * BIT_CYCLES) + (BIT_CYCLES / 2);
+    }
+    // the receiver waits for a falling edge, the level only changes at the
+    // bit boundaries of the bytes on the line
+    uint64_t next = UINT64_MAX;
+    for (unsigned i = 0; i < nodeCount; i++)
+    {
+        node_t* node = &nodes[i];
+        if (!node->frameActive || (line.now < node->frameStart) ||
+                (line.now >= node->frameStart + FRAME_CYCLES))
+        {
+            continue;
+        }
+        uint64_t t = node->frameStart + (((line.now - node->frameStart) /
+                BIT_CYCLES) + 1) * BIT_CYCLES;
+        next = (t < next) ? t : next;
+    }
+    return next;
+}
+
+/**
+ * follow the LN messages on the line
+ * @param value: the received byte
+ */
+static void checkMessage(uint8_t value)
+{
+    if (value & 0x80)
+    {
+        line.msgLength = 0;
+    }
+    else if (line.msgLength == 0)
+    {
+        return;
+    }
+    line.msg[line.msgLength++] = value;
+    if ((line.msgLength >= 2) && (line.msgLength == lnMsgLength(line.msg)))
+    {
+        uint8_t length = line.msgLength;
+        line.msgLength = 0;
+        if (!lnMsgIsChecksumCorrect(line.msg, length))
+        {
+            line.checksumErrors++;
+            return;
+        }
+        line.messages++;
+        if ((line.msg[0] == LOAD_OPCODE) && (line.msg[2] < nodeCount))
+        {
+            deliverLoad(&nodes[line.msg[2]], line.msg[1], line.now);
+        }
+    }
+    else if (line.msgLength >= LN_MSG_MAX)
+    {
+        line.msgLength = 0;
+    }
+}
+
+/**
+ * deliver a received byte to all nodes
+ * @param value: the byte
+ * @param ferr: true if the byte has a framing error
+ */
+static void deliverByte(uint8_t value, bool ferr)
+{
+    line.bytes++;
+    if (line.rxDrivers & (line.rxDrivers - 1))
+    {
+        line.sharedBytes++;
+    }
+    for (unsigned i = 0; i < nodeCount; i++)
+    {
+        (*nodes[i].api->receive)(line.now, value, ferr);
+        nodes[i].changed = true;
+    }
+    if (ferr)
+    {
+        line.framingErrors++;
+        line.msgLength = 0;
+        return;
+    }
+    checkMessage(value);
+}
+
+/**
+ * evaluate the line at a point in time (the receiver and the idle state)
+ * @param time: the time
+ */
+static void evaluateLine(uint64_t time)
+{
+    uint64_t drivers;
+
+    line.now = time;
+    bool level = getLevel(time, &drivers);
+    if (line.receiving)
+    {
+        if (time == line.rxStart + (line.rxBit * BIT_CYCLES) +
+                (BIT_CYCLES / 2))
+        {
+            uint8_t bit = line.rxBit++;
+            line.rxDrivers |= drivers;
+            if (bit == 0)
+            {
+                // no start bit (a glitch)
+                line.receiving = !level;
+            }
+            else if (bit <= 8)
+            {
+                line.rxValue |= (uint8_t) ((level ? 1 : 0) << (bit - 1));
+            }
+            else
+            {
+                line.receiving = false;
+                deliverByte(line.rxValue, !level);
+            }
+        }
+    }
+    else if (line.level && !level)
+    {
+        // falling edge: start bit
+        line.receiving = true;
+        line.rxStart = time;
+        line.rxBit = 0;
+        line.rxValue = 0;
+        line.rxDrivers = drivers;
+    }
+    line.level = level;
+    // RCIDL is cleared when the start bit is detected (in the middle of the
+    // start bit): 2 nodes that start within this time collide
+    bool idle = line.receiving ? (line.rxBit == 0) : level;
+    if (idle != line.idle)
+    {
+        line.idle = idle;
+        for (unsigned i = 0; i < nodeCount; i++)
+        {
+            (*nodes[i].api->setIdle)(line.now, idle);
+            nodes[i].changed = true;
+        }
+    }
+}
+
+/**
+ * handle the events of the line till a point in time
+ * @param time: the time
+ */
+static void advanceLine(uint64_t time)
+{
+    uint64_t next;
+
+    while ((next = getLineEvent()) <= time)
+    {
+        evaluateLine(next);
+    }
+}
+
+/**
+ * a node starts a byte on the line (see simLine_t)
+ * @param context: the node
+ * @param value: the byte
+ * @param time: the virtual time of the node
+ */
+static void lineStart(void* context, uint8_t value, uint64_t time)
+{
+    node_t* node = context;
+
+    time = (time < line.now) ? line.now : time;
+    advanceLine(time);
+    node->frameActive = true;
+    node->frameStart = time;
+    node->frameValue = value;
+    evaluateLine(time);
+}
+
+/**
+ * a node starts or ends a linebreak (see simLine_t)
+ * @param context: the node
+ * @param active: true at the start of the linebreak
+ * @param time: the virtual time of the node
+ */
+static void lineSetBreak(void* context, bool active, uint64_t time)
+{
+    node_t* node = context;
+
+    time = (time < line.now) ? line.now : time;
+    advanceLine(time);
+    if (active)
+    {
+        // the TX pin is disconnected from the EUSART, the byte in the
+        // shift register is not on the line anymore
+        node->frameActive = false;
+        if (line.breaks++ == 0)
+        {
+            line.linebreaks++;
+        }
+    }
+    else
+    {
+        line.breaks--;
+    }
+    node->lineBreak = active;
+    evaluateLine(time);
+}
+
+// </editor-fold>
+
+// <editor-fold defaultstate="collapsed" desc="simulation">
+
+/**
+ * load a node (a copy of the shared object, dlopen loads a file only once)
+ * @param image: the content of the shared object
+ * @param size: the size of the shared object
+ * @return the interface of the node
+ */
+static const lnNode_t* loadNode(const uint8_t* image, size_t size)
+{
+    char path[] = "/tmp/lnnodeXXXXXX";
+    int fd = mkstemp(path);
+
+    if ((fd < 0) || (write(fd, image, size) != (ssize_t) size))
+    {
+        perror("lncontend: copy of the node");
+        exit(1);
+    }
+    close(fd);
+    void* handle = dlopen(path, RTLD_NOW | RTLD_LOCAL);
+    unlink(path);
+    const lnNode_t* api = handle ? dlsym(handle, LN_NODE_SYMBOL) : 0;
+    if (!api)
+    {
+        fprintf(stderr, "lncontend: %s\n", dlerror());
+        exit(1);
+    }
+    return api;
+}
+
+/**
+ * read the shared object of the node
+ * @param path: the file
+ * @param size: the size of the shared object
+ * @return the content
+ */
+static uint8_t* readNode(const char* path, size_t* size)
+{
+    FILE* file = fopen(path, "rb");
+
+    if (!file)
+    {
+        perror(path);
+        exit(1);
+    }
+    fseek(file, 0, SEEK_END);
+    *size = (size_t) ftell(file);
+    fseek(file, 0, SEEK_SET);
+    uint8_t* image = malloc(*size);
+    if (!image || (fread(image, 1, *size, file) != *size))
+    {
+        fprintf(stderr, "lncontend: cannot read %s\n", path);
+        exit(1);
+    }
+    fclose(file);
+    return image;
+}
+
+/**
+ * run all nodes and the line in lockstep
+ * only the nodes with an event run, the others catch up when the line
+ * changes (see lnnode.c)
+ * @param end: the end of the simulation (in cycles)
+ * @param rate: the LN messages per s per node
+ * @param high: the fraction of the LN messages with high priority
+ */
+static void run(uint64_t end, double rate, double high)
+{
+    uint64_t nextStats = STATS_INTERVAL;
+
+    for (unsigned i = 0; i < nodeCount; i++)
+    {
+        nodes[i].next = (*nodes[i].api->nextEvent)();
+    }
+    while (true)
+    {
+        // the next event of the line, the nodes or the load generator
+        uint64_t time = getLineEvent();
+        for (unsigned i = 0; i < nodeCount; i++)
+        {
+            time = (nodes[i].next < time) ? nodes[i].next : time;
+            time = (nodes[i].nextArrival < time) ? nodes[i].nextArrival : time;
+        }
+        time = (nextStats < time) ? nextStats : time;
+        if (time >= end)
+        {
+            break;
+        }
+        for (unsigned i = 0; i < nodeCount; i++)
+        {
+            if (nodes[i].next <= time)
+            {
+                (*nodes[i].api->runUntil)(time);
+                nodes[i].changed = true;
+            }
+        }
+        advanceLine(time);
+        for (unsigned i = 0; i < nodeCount; i++)
+        {
+            if (nodes[i].nextArrival <= time)
+            {
+                (*nodes[i].api->runUntil)(time);
+                nodes[i].nextArrival = time + getInterval(rate);
+                sendLoad(&nodes[i], time, high);
+                nodes[i].changed = true;
+            }
+        }
+        if (nextStats <= time)
+        {
+            for (unsigned i = 0; i < nodeCount; i++)
+            {
+                (*nodes[i].api->collectStats)(&nodes[i].stats);
+            }
+            nextStats += STATS_INTERVAL;
+        }
+        for (unsigned i = 0; i < nodeCount; i++)
+        {
+            if (nodes[i].changed)
+            {
+                nodes[i].next = (*nodes[i].api->nextEvent)();
+                nodes[i].changed = false;
+            }
+        }
+    }
+    for (unsigned i = 0; i < nodeCount; i++)
+    {
+        (*nodes[i].api->collectStats)(&nodes[i].stats);
+    }
+}
+
+// </editor-fold>
+
+// <editor-fold defaultstate="collapsed" desc="report">
+
+/**
+ * compare 2 latencies (qsort)
+ */
+static int compareLatency(const void* a, const void* b)
+{
+    uint64_t x = *(const uint64_t*) a;
+    uint64_t y = *(const uint64_t*) b;
+    return (x > y) - (x < y);
+}
+
+/**
+ * get a percentile of sorted latencies (nearest rank)
+ * @param list: the latencies (sorted)
+ * @param fraction: the percentile (0 - 1)
+ * @return the latency (in ms)
+ */
+static double getPercentile(const latencies_t* list, double fraction)
+{
+    size_t rank = (size_t) ceil(fraction * (double) list->count);
+
+    rank = (rank < 1) ? 1 : rank;
+    return (double) list->values[rank - 1] / (double) SIM_MS(1);
+}
+
+/**
+ * print the latency percentiles of a priority class
+ * @param name: the name of the class
+ * @param list: the latencies
+ */
+static void printLatencies(const char* name, latencies_t* list)
+{
+    if (list->count == 0)
+    {
+        printf("%-8s %10u %9s %9s %9s %9s %9s\n", name, 0U, "-", "-", "-",
+                "-", "-");
+        return;
+    }
+    qsort(list->values, list->count, sizeof (uint64_t), &compareLatency);
+    printf("%-8s %10zu %9.2f %9.2f %9.2f %9.2f %9.2f\n", name, list->count,
+            getPercentile(list, 0.5), getPercentile(list, 0.9),
+            getPercentile(list, 0.99), getPercentile(list, 0.999),
+            getPercentile(list, 1.0));
+}
+
+/**
+ * print the report
+ * @param time: the duration of the measurement (in cycles)
+ * @param end: the end of the measurement (in cycles)
+ * @param verbose: true to print the results per node
+ */
+static void printReport(uint64_t time, uint64_t end, bool verbose)
+{
+    double seconds = (double) time / (double) SIM_MS(1000);
+    unsigned long offered = 0, rejected = 0, delivered = 0, waiting = 0;
+    unsigned long starved = 0;
+    lnNodeStats_t total = {0};
+    node_t* worst = &nodes[0];
+
+    for (unsigned i = 0; i < nodeCount; i++)
+    {
+        node_t* node = &nodes[i];
+        // the LN messages that still wait at the end
+        for (unsigned s = 0; s < SEQUENCES; s++)
+        {
+            if (node->pending[s])
+            {
+                waiting++;
+                if (end - node->sentAt[s] > starvation)
+                {
+                    node->starved++;
+                }
+            }
+        }
+        offered += node->offered;
+        rejected += node->rejected;
+        delivered += node->delivered;
+        starved += node->starved;
+        total.attempts += node->stats.attempts;
+        total.collisions += node->stats.collisions;
+        total.drops += node->stats.drops;
+        total.deprioritised += node->stats.deprioritised;
+        total.linebreaks += node->stats.linebreaks;
+        if (node->maxLatency > worst->maxLatency)
+        {
+            worst = node;
+        }
+    }
+
+    printf("throughput: %lu LN messages delivered (%.1f/s), %.3f of the "
+            "line rate\n", delivered, delivered / seconds,
+            delivered * LOAD_LENGTH / seconds / LN_BYTES_PER_S);
+    printf("load: %lu LN messages offered (%.1f/s), %lu rejected (LN TX "
+            "queue full), %lu waiting at the end\n", offered,
+            offered / seconds, rejected, waiting);
+    printf("line: %lu bytes, %lu LN messages, %lu bytes of more than 1 "
+            "node, %lu linebreaks, %lu framing errors, %lu checksum errors\n",
+            line.bytes, line.messages, line.sharedBytes, line.linebreaks,
+            line.framingErrors, line.checksumErrors);
+    printf("collisions: %llu of %llu transmit attempts (%.2f%%), %llu "
+            "deprioritised, %llu dropped\n",
+            (unsigned long long) total.collisions,
+            (unsigned long long) total.attempts, total.attempts ?
+            100.0 * (double) total.collisions / (double) total.attempts : 0.0,
+            (unsigned long long) total.deprioritised,
+            (unsigned long long) total.drops);
+    printf("%-8s %10s %9s %9s %9s %9s %9s\n", "latency", "messages",
+            "p50 (ms)", "p90", "p99", "p99.9", "max");
+    printLatencies("high", &latencies[0]);
+    printLatencies("low", &latencies[1]);
+    printf("starvation (> %.0f ms): %lu LN messages, worst node %u "
+            "(max. %.2f ms)\n", (double) starvation / (double) SIM_MS(1),
+            starved, worst->address,
+            (double) worst->maxLatency / (double) SIM_MS(1));
+
+    if (!verbose)
+    {
+        return;
+    }
+    printf("\n%4s %8s %8s %9s %8s %8s %10s %9s %9s\n", "node", "offered",
+            "rejected", "delivered", "starved", "attempts", "collisions",
+            "avg (ms)", "max (ms)");
+    for (unsigned i = 0; i < nodeCount; i++)
+    {
+        node_t* node = &nodes[i];
+        printf("%4u %8lu %8lu %9lu %8lu %8llu %10llu %9.2f %9.2f\n",
+                node->address, node->offered, node->rejected,
+                node->delivered, node->starved,
+                (unsigned long long) node->stats.attempts,
+                (unsigned long long) node->stats.collisions,
+                node->delivered ? (double) node->totalLatency /
+                (double) node->delivered / (double) SIM_MS(1) : 0.0,
+                (double) node->maxLatency / (double) SIM_MS(1));
+    }
+}
+
+// </editor-fold>
+
+/**
+ * main (start of program)
+ */
+int main(int argc, char** argv)
+{
+    double seconds = 10.0;
+    double load = 0.3;
+    double high = 0.0;
+    double threshold = 1000.0;
+    unsigned long seed = 1;
+    bool verbose = false;
+    char path[1024];
+    int option;
+
+    // default: lnnode.so in the directory of lncontend
+    const char* slash = strrchr(argv[0], '/');
+    snprintf(path, sizeof (path), "%.*slnnode.so",
+            slash ? (int) (slash - argv[0] + 1) : 0, argv[0]);
+    while ((option = getopt(argc, argv, "n:t:l:p:w:s:vL:")) != -1)
+    {
+        switch (option)
+        {
+            case 'n':
+                nodeCount = (unsigned) strtoul(optarg, 0, 0);
+                break;
+            case 't':
+                seconds = strtod(optarg, 0);
+                break;
+            case 'l':
+                load = strtod(optarg, 0);
+                break;
+            case 'p':
+                high = strtod(optarg, 0);
+                break;
+            case 'w':
+                threshold = strtod(optarg, 0);
+                break;
+            case 's':
+                seed = strtoul(optarg, 0, 0);
+                break;
+            case 'v':
+                verbose = true;
+                break;
+            case 'L':
+                snprintf(path, sizeof (path), "%s", optarg);
+                break;
+            default:
+                fprintf(stderr, "usage: %s [-n nodes] [-t seconds] "
+                        "[-l load] [-p fraction] [-w ms] [-s seed] [-v] "
+                        "[-L lnnode.so]\n", argv[0]);
+                return 1;
+        }
+    }
+    if ((nodeCount < 1) || (nodeCount > MAX_NODES) || (seconds <= 0) ||
+            (load <= 0) || (high < 0) || (high > 1) || (threshold <= 0))
+    {
+        fprintf(stderr, "%s: 1 <= nodes <= %u, seconds > 0, load > 0, "
+                "0 <= fraction <= 1, ms > 0\n", argv[0], MAX_NODES);
+        return 1;
+    }
+    randomState = (seed * 0x9e3779b97f4a7c15ULL) | 1U;
+    starvation = (uint64_t) (threshold * (double) SIM_MS(1));
+
+    // power up the nodes, every node on its own copy of the firmware
+    size_t size;
+    uint8_t* image = readNode(path, &size);
+    line.now = 0;
+    line.level = true;
+    line.idle = true;
+    for (unsigned i = 0; i < nodeCount; i++)
+    {
+        node_t* node = &nodes[i];
+        node->api = loadNode(image, size);
+        node->address = (uint8_t) i;
+        node->line.start = &lineStart;
+        node->line.setBreak = &lineSetBreak;
+        node->line.context = node;
+        (*node->api->init)(node->address, &node->line);
+    }
+    free(image);
+
+    // the load starts after the warm up
+    double rate = load * LN_BYTES_PER_S / LOAD_LENGTH / nodeCount;
+    for (unsigned i = 0; i < nodeCount; i++)
+    {
+        nodes[i].nextArrival = WARMUP + getInterval(rate);
+    }
+    uint64_t time = (uint64_t) (seconds * (double) SIM_MS(1000));
+    run(WARMUP + time, rate, high);
+
+    printf("%u nodes, %.1f s, offered load %.2f of the line rate (%.1f LN "
+            "messages/s, %u bytes), high priority %.2f, seed %lu\n",
+            nodeCount, seconds, load, rate * nodeCount, LOAD_LENGTH, high,
+            seed);
+    printReport(time, WARMUP + time, verbose);
+    return 0;
+}
@@ -0,0 +1,147 @@
+/*
+ * file: lndiverge.c
+ * author: J. van Hooydonk
+ * comments: host program, checks that boards powered up together draw
+ * different priority delays (and don't collide in lockstep)
+ *
+ * usage: lndiverge [-n boards] [-d draws] [-w window] [-c]
+ *  -n: the number of boards, with DIP switch address 0 .. n - 1 (default 16)
+ *  -d: the number of draws after which all boards must be diverged
+ *      (default 4)
+ *  -w: the collision window in us, 2 boards that start within this window
+ *      collide (default 60, 1 bit time)
+ *  -c: use the constant start state of the random generator (no seed),
+ *      this shows the behaviour before the seed per board
+ *
+ * every board is powered up (init) and draws the CMP delays of its first
+ * transmit attempts with startCmpDelay, for every pair of boards the number
+ * of draws is counted till their delays are in a different collision window
+ * the program fails (exit code 1) if a pair is still in lockstep after the
+ * given number of draws
+ *
+ * revision history:
+ *  v1.0 Creation (16/10/2026)
+ */
+
+#define _POSIX_C_SOURCE 200809L
+
+#include <stdio.h>
+#include <stdlib.h>
+#include <unistd.h>
+#include "firmware.c"
+#include "pic18_sim.h"
+
+// definitions
+#define MAX_BOARDS 256U
+#define MAX_DRAWS 32U
+
+// variables
+static uint16_t delays[MAX_BOARDS][MAX_DRAWS];
+
+/**
+ * power up a board and draw its CMP delays
+ * @param address: the DIP switch address of the board
+ * @param draws: the number of delays
+ * @param constant: true to use the constant start state (no seed)
+ */
+static void drawDelays(uint8_t address, unsigned draws, bool constant)
+{
+    simReset();
+    simSetDipAddress(address);
+    init();
+    if (constant)
+    {
+        lastRandomValue = 0;
+    }
+    for (unsigned i = 0; i < draws; i++)
+    {
+        startCmpDelay();
+        // timer 1 counts up to the overflow, the delay is the complement
+        uint16_t timer = (uint16_t) ((TMR1H << 8) | TMR1L);
+        // 1 timer tick = 0.5us
+        delays[address][i] = (uint16_t) (((uint16_t) ~timer) / 2);
+    }
+}
+
+/**
+ * main (start of program)
+ */
+int main(int argc, char** argv)
+{
+    unsigned boards = 16;
+    unsigned draws = 4;
+    unsigned window = 60;
+    bool constant = false;
+    int option;
+
+    while ((option = getopt(argc, argv, "n:d:w:c")) != -1)
+    {
+        switch (option)
+        {
+            case 'n':
+                boards = (unsigned) strtoul(optarg, 0, 0);
+                break;
+            case 'd':
+                draws = (unsigned) strtoul(optarg, 0, 0);
+                break;
+            case 'w':
+                window = (unsigned) strtoul(optarg, 0, 0);
+                break;
+            case 'c':
+                constant = true;
+                break;
+            default:
+                fprintf(stderr, "usage: %s [-n boards] [-d draws] "
+                        "[-w window] [-c]\n", argv[0]);
+                return 1;
+        }
+    }
+    if ((boards < 2) || (boards > MAX_BOARDS) || (draws < 1) ||
+            (draws > MAX_DRAWS) || (window < 1))
+    {
+        fprintf(stderr, "%s: 2 <= boards <= %u, 1 <= draws <= %u, "
+                "window >= 1\n", argv[0], MAX_BOARDS, MAX_DRAWS);
+        return 1;
+    }
+
+    for (unsigned address = 0; address < boards; address++)
+    {
+        drawDelays((uint8_t) address, draws, constant);
+    }
+
+    // count the pairs that are still in lockstep after every draw
+    unsigned lockstep[MAX_DRAWS] = {0};
+    unsigned pairs = 0;
+    for (unsigned a = 0; a < boards; a++)
+    {
+        for (unsigned b = a + 1; b < boards; b++)
+        {
+            pairs++;
+            for (unsigned i = 0; i < draws; i++)
+            {
+                int difference = (int) delays[a][i] - (int) delays[b][i];
+                if ((unsigned) abs(difference) >= window)
+                {
+                    break;
+                }
+                lockstep[i]++;
+            }
+        }
+    }
+
+    printf("%u boards, %u pairs, collision window %u us%s\n", boards, pairs,
+            window, constant ? " (constant start state)" : "");
+    printf("%6s %16s\n", "draw", "pairs lockstep");
+    for (unsigned i = 0; i < draws; i++)
+    {
+        printf("%6u %16u\n", i + 1, lockstep[i]);
+    }
+    if (lockstep[draws - 1] > 0)
+    {
+        printf("FAIL: %u pairs still in lockstep after %u draws\n",
+                lockstep[draws - 1], draws);
+        return 1;
+    }
+    printf("OK: all pairs diverged within %u draws\n", draws);
+    return 0;
+}
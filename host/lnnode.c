@@ -0,0 +1,154 @@
+/*
+ * file: lnnode.c
+ * author: J. van Hooydonk
+ * comments: LN node of lncontend, the firmware on the simulated device
+ * behind the interface of lnnode.h (built as shared object lnnode.so)
+ *
+ * revision history:
+ *  v1.0 Creation (16/10/2026)
+ *  v1.1 the pending LN messages are retried in the main loop (16/10/2026)
+ *  v1.2 the DIP switch address is debounced in the main loop (16/10/2026)
+ */
+
+#define _POSIX_C_SOURCE 200809L
+
+#include <string.h>
+#include "firmware.c"
+#include "pic18_sim.h"
+#include "lnnode.h"
+
+// definitions
+// estimated duration of 1 pass of the main loop (see lnsim.c)
+#define MAIN_LOOP_CYCLES SIM_US(250)
+
+// variables
+static uint64_t nextMainLoop;
+
+/**
+ * power up the node
+ * @param address: the DIP switch address of the board
+ * @param line: the external LN line
+ */
+static void nodeInit(uint8_t address, const simLine_t* line)
+{
+    simReset();
+    simSetDipAddress(address);
+    simSetLine(line);
+    init();
+    nextMainLoop = simNow();
+}
+
+/**
+ * get the time of the next event of the node
+ * @return the time (in cycles)
+ */
+static uint64_t nodeNextEvent(void)
+{
+    uint64_t next = simNextEvent();
+
+    return (next < nextMainLoop) ? next : nextMainLoop;
+}
+
+/**
+ * let the node run till a point in time, the main loop of the firmware runs
+ * every MAIN_LOOP_CYCLES
+ * @param time: the time (in cycles)
+ */
+static void nodeRunUntil(uint64_t time)
+{
+    simRunUntil(time);
+    if (simNow() >= nextMainLoop)
+    {
+        updateLeds();
+        lnRxRingHandler();
+        lnTxPendingHandler();
+        dipSwitchHandler();
+        nextMainLoop = simNow() + MAIN_LOOP_CYCLES;
+    }
+}
+
+/**
+ * let the node catch up with the line (a node only runs at its own events,
+ * the line has no event between its last event and this time)
+ * @param time: the time of the line (in cycles)
+ */
+static void nodeCatchUp(uint64_t time)
+{
+    if (simNow() < time)
+    {
+        simRun(time - simNow());
+    }
+}
+
+/**
+ * receive a byte from the line
+ * @param time: the time of the line (in cycles)
+ * @param value: the byte
+ * @param ferr: true if the byte has a framing error
+ */
+static void nodeReceive(uint64_t time, uint8_t value, bool ferr)
+{
+    nodeCatchUp(time);
+    simLineReceive(value, ferr);
+}
+
+/**
+ * set the idle state of the line
+ * @param time: the time of the line (in cycles)
+ * @param idle: true if the line is idle
+ */
+static void nodeSetIdle(uint64_t time, bool idle)
+{
+    nodeCatchUp(time);
+    simLineSetIdle(idle);
+}
+
+/**
+ * add a LN message to the LN TX queue (like the LN TX handlers of general.c)
+ * @param msg: the LN message (with checksum)
+ * @param length: the length of the LN message
+ * @param high: true for high priority, false for low priority
+ * @return true: if the LN message is added
+ */
+static bool nodeSend(const uint8_t* msg, uint8_t length, bool high)
+{
+    uint8_t lnTxMsg[LN_TX_MSG_SIZE];
+
+    if (length > LN_TX_MSG_SIZE)
+    {
+        return false;
+    }
+    memcpy(lnTxMsg, msg, length);
+    LN_TX_LOCK(giel);
+    lnTxStatus_t status = lnTxMessageHandler(lnTxMsg, length,
+            high ? LN_TX_PRIO_HIGH : LN_TX_PRIO_LOW);
+    LN_TX_UNLOCK(giel);
+    return (status == LN_TX_OK);
+}
+
+/**
+ * add the LN statistics of the firmware to the totals and clear them
+ * @param stats: the totals
+ */
+static void nodeCollectStats(lnNodeStats_t* stats)
+{
+    stats->attempts += lnStats.attempts;
+    stats->collisions += lnStats.collisions;
+    stats->drops += lnStats.drops;
+    stats->deprioritised += lnStats.deprioritised;
+    stats->txRejected += lnStats.txRejected;
+    stats->framingErrors += lnStats.framingErrors;
+    stats->linebreaks += lnStats.linebreaks;
+    lnClearStats();
+}
+
+// interface of the node (see LN_NODE_SYMBOL)
+const lnNode_t lnNode = {
+    &nodeInit,
+    &nodeNextEvent,
+    &nodeRunUntil,
+    &nodeReceive,
+    &nodeSetIdle,
+    &nodeSend,
+    &nodeCollectStats
+};
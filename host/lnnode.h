@@ -0,0 +1,57 @@
+/*
+ * file: lnnode.h
+ * author: J. van Hooydonk
+ * comments: interface of a LN node of lncontend (the firmware on the
+ * simulated device, built as shared object lnnode.so)
+ *
+ * lncontend loads a separate copy of lnnode.so per node, so every node has
+ * its own variables of the firmware and the simulator, and finds the
+ * interface of the node with dlsym (LN_NODE_SYMBOL)
+ *
+ * revision history:
+ *  v1.0 Creation (16/10/2026)
+ */
+
+// this is a guard condition so that contents of this file are not included
+// more than once
+#ifndef LNNODE_H
+#define	LNNODE_H
+
+#include "pic18_sim.h"
+
+// definitions
+#define LN_NODE_SYMBOL "lnNode"
+
+// LN statistics of the firmware of a node (added up, the counters of the
+// firmware are 16 bit)
+
+typedef struct {
+    uint64_t attempts;
+    uint64_t collisions;
+    uint64_t drops;
+    uint64_t deprioritised;
+    uint64_t txRejected;
+    uint64_t framingErrors;
+    uint64_t linebreaks;
+} lnNodeStats_t;
+
+// interface of a node
+
+typedef struct {
+    // power up the node with its DIP switch address on the external line
+    void (*init)(uint8_t, const simLine_t*);
+    // time of the next event of the node (in cycles)
+    uint64_t (*nextEvent)(void);
+    // let the node run till a point in time (ISR routines and main loop)
+    void (*runUntil)(uint64_t);
+    // a byte received from the line (time, byte, framing error)
+    void (*receive)(uint64_t, uint8_t, bool);
+    // the idle state of the line (time, idle)
+    void (*setIdle)(uint64_t, bool);
+    // add a LN message to the LN TX queue (message, length, high priority)
+    bool (*send)(const uint8_t*, uint8_t, bool);
+    // add the LN statistics of the firmware to the totals (and clear them)
+    void (*collectStats)(lnNodeStats_t*);
+} lnNode_t;
+
+#endif	/* LNNODE_H */
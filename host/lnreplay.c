@@ -0,0 +1,268 @@
+/*
+ * file: lnreplay.c
+ * author: J. van Hooydonk
+ * comments: host program, replays a LN capture through the LN receiver of
+ * the firmware (rxHandler, lnRxRingHandler and the opcode table of
+ * general.c) at maximum speed
+ *
+ * usage: lnreplay [-a address] [-n repeats] [-m bytes] [-b] [capture]
+ *  -a: the DIP switch address of the board (default 1)
+ *  -n: the number of times the capture is replayed (default 100)
+ *  -m: the number of bytes between 2 passes of the main loop
+ *      (lnRxRingHandler), default 1 (every byte), with a bigger value the
+ *      LN RX ring must hold the LN messages longer (LN_RX_IN_MAIN)
+ *  -b: the capture is binary (the bytes on LN), otherwise it is text with 1
+ *      LN message in hex per line (as printed by lnsim or the JMRI monitor,
+ *      the bytes after '[' or at the begin of the line)
+ *  capture: the file with the capture (default stdin)
+ *
+ * the program reports the LN messages per opcode of the opcode table that
+ * reached their handler, the changes of the CAW of the turnouts (CAWL/CAWR)
+ * and of the aspect of the signals of this board made by the handlers of the
+ * firmware (the AW and S list before and after the handler, a command that
+ * doesn't change the state isn't counted), the RX statistics (dropped bytes,
+ * checksum errors, high water of the LN RX ring) and the speed of the
+ * receiver on the host compared to the line rate of LN (16.66 kbaud,
+ * 1 start + 8 data + 1 stop bit = 1666 bytes/s)
+ *
+ * revision history:
+ *  v1.0 Creation (16/10/2026)
+ *  v1.1 the CAW and aspect changes are observed in the AW and S list
+ *       (16/10/2026)
+ */
+
+#define _POSIX_C_SOURCE 200809L
+
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <time.h>
+#include <unistd.h>
+#include "firmware.c"
+#include "pic18_sim.h"
+#include "ln_msg.h"
+
+// definitions
+#define LN_BYTES_PER_S 1666.6
+#define REPLAY_OPCODES (sizeof (lnRxOpcodeTable) / sizeof (lnRxOpcode_t))
+
+// variables
+static void replayHandler(uint8_t*, uint8_t);
+static lnRxOpcode_t replayOpcodes[REPLAY_OPCODES];
+static unsigned long handled[REPLAY_OPCODES];
+static unsigned long cawChanges;
+static unsigned long aspectChanges;
+static unsigned long droppedBytes;
+static unsigned long checksumErrors;
+static uint8_t highWater;
+static uint8_t* capture;
+static size_t captureLength;
+
+/**
+ * handler of the replay opcode table, counts the LN message, passes it to
+ * the handler of the opcode table of the firmware and counts the CAW and
+ * aspect changes that the handler made (the ISR doesn't run during the
+ * replay, so every change is made by the handler)
+ * @param lnRxMsg: the received LN message
+ * @param length: the length of the LN message
+ */
+static void replayHandler(uint8_t* lnRxMsg, uint8_t length)
+{
+    uint8_t entry = getLnRxOpcodeEntry(lnRxMsg[0]);
+    AWCON_t aw[8];
+    SCON_t s[8];
+
+    handled[entry]++;
+    memcpy(aw, awList, sizeof (aw));
+    memcpy(s, sList, sizeof (s));
+    (*lnRxOpcodeTable[entry].handler)(lnRxMsg, length);
+    for (uint8_t i = 0; i < 8; i++)
+    {
+        if ((awList[i].CAWL != aw[i].CAWL) || (awList[i].CAWR != aw[i].CAWR))
+        {
+            cawChanges++;
+        }
+        if ((sList[i].aspect != s[i].aspect) ||
+                (sList[i].CVT_mode != s[i].CVT_mode))
+        {
+            aspectChanges++;
+        }
+    }
+}
+
+/**
+ * add a byte to the capture
+ * @param data: the byte
+ */
+static void addByte(uint8_t data)
+{
+    static size_t size;
+
+    if (captureLength == size)
+    {
+        size = size ? size * 2 : 4096;
+        capture = realloc(capture, size);
+        if (!capture)
+        {
+            fprintf(stderr, "lnreplay: out of memory\n");
+            exit(1);
+        }
+    }
+    capture[captureLength++] = data;
+}
+
+/**
+ * read the capture
+ * @param file: the file
+ * @param binary: true = binary capture, false = text (hex)
+ */
+static void readCapture(FILE* file, bool binary)
+{
+    if (binary)
+    {
+        int c;
+        while ((c = fgetc(file)) != EOF)
+        {
+            addByte((uint8_t) c);
+        }
+        return;
+    }
+    char line[1024];
+    uint8_t msg[LN_MSG_MAX];
+    while (fgets(line, sizeof (line), file))
+    {
+        uint8_t length = lnMsgParse(msg, line);
+        for (uint8_t i = 0; i < length; i++)
+        {
+            addByte(msg[i]);
+        }
+    }
+}
+
+/**
+ * get the time of the host
+ * @return the time (in s)
+ */
+static double getTime(void)
+{
+    struct timespec now;
+
+    clock_gettime(CLOCK_MONOTONIC, &now);
+    return (double) now.tv_sec + (now.tv_nsec / 1e9);
+}
+
+/**
+ * main (start of program)
+ */
+int main(int argc, char** argv)
+{
+    uint8_t address = 1;
+    unsigned long repeats = 100;
+    unsigned long mainLoop = 1;
+    bool binary = false;
+    int option;
+
+    while ((option = getopt(argc, argv, "a:n:m:b")) != -1)
+    {
+        switch (option)
+        {
+            case 'a':
+                address = (uint8_t) strtoul(optarg, 0, 0);
+                break;
+            case 'n':
+                repeats = strtoul(optarg, 0, 0);
+                break;
+            case 'm':
+                mainLoop = strtoul(optarg, 0, 0);
+                break;
+            case 'b':
+                binary = true;
+                break;
+            default:
+                fprintf(stderr, "usage: %s [-a address] [-n repeats] "
+                        "[-m bytes] [-b] [capture]\n", argv[0]);
+                return 1;
+        }
+    }
+    if ((repeats < 1) || (mainLoop < 1))
+    {
+        fprintf(stderr, "%s: repeats >= 1, bytes >= 1\n", argv[0]);
+        return 1;
+    }
+    FILE* file = stdin;
+    if (optind < argc)
+    {
+        file = fopen(argv[optind], binary ? "rb" : "r");
+        if (!file)
+        {
+            perror(argv[optind]);
+            return 1;
+        }
+    }
+    readCapture(file, binary);
+    if (captureLength == 0)
+    {
+        fprintf(stderr, "%s: empty capture\n", argv[0]);
+        return 1;
+    }
+
+    // power up the board and put the replay opcode table in front of the
+    // opcode table of the firmware
+    simReset();
+    simSetDipAddress(address);
+    init();
+    for (uint8_t i = 0; i < REPLAY_OPCODES; i++)
+    {
+        replayOpcodes[i] = lnRxOpcodeTable[i];
+        replayOpcodes[i].handler = &replayHandler;
+    }
+    lnRxOpcodes = replayOpcodes;
+    lnRxOpcodesSize = REPLAY_OPCODES;
+    lnClearStats();
+
+    // replay the capture
+    unsigned long count = 0;
+    double start = getTime();
+    for (unsigned long r = 0; r < repeats; r++)
+    {
+        for (size_t i = 0; i < captureLength; i++)
+        {
+            rxHandler(capture[i]);
+            if (++count >= mainLoop)
+            {
+                lnRxRingHandler();
+                count = 0;
+            }
+        }
+        // the RX statistics are 16 bit, add them up per replay
+        droppedBytes += lnStats.rxDroppedBytes;
+        checksumErrors += lnStats.checksumErrors;
+        if (lnStats.rxHighWater > highWater)
+        {
+            highWater = lnStats.rxHighWater;
+        }
+        lnClearStats();
+    }
+    lnRxRingHandler();
+    double time = getTime() - start;
+
+    unsigned long long bytes = (unsigned long long) captureLength * repeats;
+    unsigned long messages = 0;
+    printf("capture %zu bytes, %lu repeats, main loop every %lu bytes, "
+            "board %u\n", captureLength, repeats, mainLoop, address);
+    printf("%-8s %12s\n", "opcode", "messages");
+    for (uint8_t i = 0; i < REPLAY_OPCODES; i++)
+    {
+        printf("0x%02x     %12lu\n", lnRxOpcodeTable[i].opcode, handled[i]);
+        messages += handled[i];
+    }
+    printf("changed CAW %lu, aspect %lu (this board)\n", cawChanges,
+            aspectChanges);
+    printf("dropped bytes %lu, checksum errors %lu, RX ring high water "
+            "%u/%u\n", droppedBytes, checksumErrors, highWater,
+            LN_RX_SLOTS - 1);
+    printf("%.3f s, %.1f ns/byte, %.0f messages/s, %.0f bytes/s = %.0fx the "
+            "LN line rate\n", time, time * 1e9 / (double) bytes,
+            messages / time, bytes / time, bytes / time / LN_BYTES_PER_S);
+    return 0;
+}
@@ -0,0 +1,330 @@
+/*
+ * file: lnrxcheck.c
+ * author: J. van Hooydonk
+ * comments: host program, checks the LN receiver (rxHandler) against a
+ * reference receiver that buffers the LN message and tests its length and
+ * checksum at the end (isChecksumCorrect)
+ *
+ * usage: lnrxcheck [-n messages] [-s seed]
+ *  -n: the number of LN messages of the random streams (default 200000)
+ *  -s: the seed of the random streams (default 1)
+ *
+ * the receivers get the same byte streams:
+ *  - all 2 byte sequences (every startbyte with every 2nd byte)
+ *  - all 4 byte LN messages of 1 opcode (every data byte and checksum)
+ *  - every single byte change of a valid LN message of each length class
+ *  - random streams of valid, corrupted, truncated and skipped LN messages
+ * after every byte the received LN messages and the RX statistics must be
+ * the same, the program fails (exit code 1) at the first difference
+ *
+ * revision history:
+ *  v1.0 Creation (16/10/2026)
+ */
+
+#define _POSIX_C_SOURCE 200809L
+
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <unistd.h>
+#include "firmware.c"
+#include "pic18_sim.h"
+#include "ln_msg.h"
+
+// definitions
+#define CHECK_MSG_MAX 16U
+
+// received LN message
+typedef struct {
+    uint8_t length;
+    uint8_t values[CHECK_MSG_MAX];
+} checkMsg_t;
+
+// reference receiver
+typedef struct {
+    uint8_t entry;
+    uint8_t length;
+    uint8_t values[LN_RX_SLOT_SIZE];
+    bool skip;
+    uint16_t checksumErrors;
+    uint16_t droppedBytes;
+} checkRef_t;
+
+// variables
+// opcode table of the check, 1 opcode per length class (2, 4, 6 and
+// variable) and a variable LN message as long as a slot
+static void captureHandler(uint8_t*, uint8_t);
+static const lnRxOpcode_t checkOpcodes[] = {
+    {0x83, 0x02, &captureHandler},
+    {0xb0, 0x04, &captureHandler},
+    {0xd0, 0x06, &captureHandler},
+    {0xed, 0x0b, &captureHandler},
+    {0xe5, LN_RX_SLOT_SIZE, &captureHandler}
+};
+#define CHECK_OPCODES (sizeof (checkOpcodes) / sizeof (checkOpcodes[0]))
+static checkMsg_t received;
+static bool isReceived;
+static checkRef_t ref;
+static checkMsg_t refReceived;
+static bool isRefReceived;
+static uint64_t bytes;
+static uint64_t messages;
+
+/**
+ * handler of the opcode table, keeps the received LN message
+ * @param lnRxMsg: the received LN message
+ * @param length: the length of the LN message
+ */
+static void captureHandler(uint8_t* lnRxMsg, uint8_t length)
+{
+    received.length = length;
+    memcpy(received.values, lnRxMsg, length);
+    isReceived = true;
+}
+
+/**
+ * reference receiver: buffers the LN message and tests the length and the
+ * checksum at the end (as rxHandler before the running checksum)
+ * @param data: the received byte
+ */
+static void refRxHandler(uint8_t data)
+{
+    if (data & 0x80)
+    {
+        ref.droppedBytes += ref.length;
+        ref.length = 0;
+        ref.skip = true;
+        for (uint8_t i = 0; i < CHECK_OPCODES; i++)
+        {
+            if (checkOpcodes[i].opcode == data)
+            {
+                ref.entry = i;
+                ref.skip = false;
+                ref.values[0] = data;
+                ref.length = 1;
+            }
+        }
+    }
+    else if (ref.skip)
+    {
+        // byte of a skipped LN message
+    }
+    else if ((ref.length > 0) && (ref.length < LN_RX_SLOT_SIZE))
+    {
+        ref.values[ref.length++] = data;
+        // length of the LN message from the opcode (or the 2nd byte)
+        uint8_t length = (uint8_t) (((ref.values[0] & 0x60) >> 4) + 2);
+        bool variable = (length > 6);
+        if (variable)
+        {
+            length = ref.values[1];
+        }
+        if (variable && (ref.length == 2) &&
+                (length != checkOpcodes[ref.entry].length))
+        {
+            ref.droppedBytes += ref.length;
+            ref.length = 0;
+            ref.skip = true;
+        }
+        else if (length == ref.length)
+        {
+            if (isChecksumCorrect(ref.values, ref.length))
+            {
+                refReceived.length = ref.length;
+                memcpy(refReceived.values, ref.values, ref.length);
+                isRefReceived = true;
+            }
+            else
+            {
+                ref.checksumErrors++;
+                ref.droppedBytes += ref.length;
+            }
+            ref.length = 0;
+        }
+    }
+    else
+    {
+        ref.droppedBytes++;
+    }
+}
+
+/**
+ * give 1 byte to both receivers and compare them
+ * @param data: the received byte
+ */
+static void feed(uint8_t data)
+{
+    isReceived = false;
+    isRefReceived = false;
+    rxHandler(data);
+    lnRxRingHandler();
+    refRxHandler(data);
+    bytes++;
+
+    bool same = (isReceived == isRefReceived) &&
+            (lnStats.checksumErrors == ref.checksumErrors) &&
+            (lnStats.rxDroppedBytes == ref.droppedBytes);
+    if (same && isReceived)
+    {
+        same = (received.length == refReceived.length) &&
+                (memcmp(received.values, refReceived.values,
+                received.length) == 0);
+        messages++;
+    }
+    if (!same)
+    {
+        printf("FAIL: byte %llu (0x%02x): received %d/%d, checksum errors "
+                "%u/%u, dropped bytes %u/%u (rxHandler/reference)\n",
+                (unsigned long long) bytes, data, isReceived, isRefReceived,
+                lnStats.checksumErrors, ref.checksumErrors,
+                lnStats.rxDroppedBytes, ref.droppedBytes);
+        exit(1);
+    }
+}
+
+/**
+ * give a byte sequence to both receivers
+ * @param data: the bytes
+ * @param length: the number of bytes
+ */
+static void feedAll(const uint8_t* data, uint8_t length)
+{
+    for (uint8_t i = 0; i < length; i++)
+    {
+        feed(data[i]);
+    }
+}
+
+/**
+ * build a valid LN message of an entry of the opcode table
+ * @param msg: the buffer for the LN message
+ * @param entry: the entry of the opcode table
+ * @return the length of the LN message
+ */
+static uint8_t buildMessage(uint8_t* msg, uint8_t entry)
+{
+    uint8_t length = checkOpcodes[entry].length;
+
+    msg[0] = checkOpcodes[entry].opcode;
+    for (uint8_t i = 1; i < length - 1; i++)
+    {
+        msg[i] = (uint8_t) (rand() & 0x7f);
+    }
+    if ((msg[0] & 0x60) == 0x60)
+    {
+        msg[1] = length;
+    }
+    return lnMsgSetChecksum(msg, length);
+}
+
+/**
+ * main (start of program)
+ */
+int main(int argc, char** argv)
+{
+    unsigned long count = 200000;
+    unsigned seed = 1;
+    uint8_t msg[CHECK_MSG_MAX];
+    int option;
+
+    while ((option = getopt(argc, argv, "n:s:")) != -1)
+    {
+        switch (option)
+        {
+            case 'n':
+                count = strtoul(optarg, 0, 0);
+                break;
+            case 's':
+                seed = (unsigned) strtoul(optarg, 0, 0);
+                break;
+            default:
+                fprintf(stderr, "usage: %s [-n messages] [-s seed]\n",
+                        argv[0]);
+                return 1;
+        }
+    }
+
+    // power up the board and replace the opcode table
+    simReset();
+    init();
+    lnRxOpcodes = checkOpcodes;
+    lnRxOpcodesSize = CHECK_OPCODES;
+    lnClearStats();
+    srand(seed);
+
+    // all 2 byte sequences
+    for (uint16_t opcode = 0x80; opcode <= 0xff; opcode++)
+    {
+        for (uint16_t data = 0; data <= 0xff; data++)
+        {
+            feed((uint8_t) opcode);
+            feed((uint8_t) data);
+        }
+    }
+    printf("2 byte sequences: OK\n");
+
+    // all 4 byte LN messages of OPC_SW_REQ (every checksum)
+    for (uint16_t sw1 = 0; sw1 <= 0x7f; sw1++)
+    {
+        for (uint16_t sw2 = 0; sw2 <= 0x7f; sw2++)
+        {
+            for (uint16_t checksum = 0; checksum <= 0xff; checksum++)
+            {
+                feed(0xb0);
+                feed((uint8_t) sw1);
+                feed((uint8_t) sw2);
+                feed((uint8_t) checksum);
+            }
+        }
+    }
+    printf("4 byte LN messages: OK\n");
+
+    // every single byte change of a valid LN message
+    for (uint8_t entry = 0; entry < CHECK_OPCODES; entry++)
+    {
+        uint8_t length = buildMessage(msg, entry);
+        for (uint8_t i = 0; i < length; i++)
+        {
+            uint8_t original = msg[i];
+            for (uint16_t value = 0; value <= 0xff; value++)
+            {
+                msg[i] = (uint8_t) value;
+                feedAll(msg, length);
+            }
+            msg[i] = original;
+        }
+    }
+    printf("single byte changes: OK\n");
+
+    // random streams
+    for (unsigned long n = 0; n < count; n++)
+    {
+        uint8_t length = buildMessage(msg, (uint8_t) (rand() % CHECK_OPCODES));
+        switch (rand() % 8)
+        {
+            case 0:
+                // corrupted byte
+                msg[rand() % length] ^= (uint8_t) (1 << (rand() % 8));
+                break;
+            case 1:
+                // truncated LN message
+                length = (uint8_t) (1 + (rand() % length));
+                break;
+            case 2:
+                // LN message that is skipped (opcode not in the table)
+                msg[0] = (uint8_t) (0x80 | (rand() & 0x7f));
+                break;
+            default:
+                // valid LN message
+                break;
+        }
+        feedAll(msg, length);
+    }
+    printf("random streams (%lu LN messages): OK\n", count);
+
+    printf("OK: %llu bytes, %llu LN messages received, checksum errors %u, "
+            "dropped bytes %u\n", (unsigned long long) bytes,
+            (unsigned long long) messages, lnStats.checksumErrors,
+            lnStats.rxDroppedBytes);
+    return 0;
+}
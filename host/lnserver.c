@@ -0,0 +1,542 @@
+/*
+ * file: lnserver.c
+ * author: J. van Hooydonk
+ * comments: host program, runs the firmware on the simulated device behind a
+ * LoconetOverTcp (LbServer) socket, so JMRI or other LN software can send
+ * LN messages to the board and receive its reports without a LN bus
+ *
+ * usage: lnserver [-a address] [-p port] [-x speed] [-q]
+ *  -a: the DIP switch address of the board (default 1)
+ *  -p: the TCP port on localhost (default 1234, the port of LbServer)
+ *  -x: the speed of the virtual clock, 1 = real time (default), 2 = twice
+ *      as fast, 0 = as fast as possible
+ *  -q: quiet, do not print the clients and the LN traffic
+ *
+ * the LbServer protocol (text, 1 command per line):
+ *  server: VERSION <text> (after the connect)
+ *  client: SEND <hex bytes> (a LN message with checksum)
+ *  server: SENT OK (the LN message is on the line) or SENT ERROR <reason>
+ *  server: RECEIVE <hex bytes> (every LN message on the line, also the
+ *          LN messages of the clients)
+ * the LN messages of all clients are sent by the external device of the
+ * simulator, 1 at a time in the order of arrival (after the carrier detect
+ * time, like a LocoNet interface), a LN message that is not on the line
+ * as sent (collision with the board) gets SENT ERROR
+ * at the end (SIGINT, SIGTERM) the program prints the number of LN messages
+ * and the virtual time from SEND till SENT OK
+ *
+ * revision history:
+ *  v1.0 Creation (16/10/2026)
+ *  v1.1 the pending LN messages are retried in the main loop (16/10/2026)
+ *  v1.2 the DIP switch address is debounced in the main loop (16/10/2026)
+ */
+
+#define _POSIX_C_SOURCE 200809L
+
+#include <arpa/inet.h>
+#include <netinet/in.h>
+#include <poll.h>
+#include <signal.h>
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <sys/socket.h>
+#include <time.h>
+#include <unistd.h>
+#include "firmware.c"
+#include "pic18_sim.h"
+#include "ln_msg.h"
+
+// definitions
+#define DEFAULT_PORT 1234
+#define MAX_CLIENTS 8U
+#define CLIENT_LINE 512U
+#define MAX_PENDING 4096U
+// estimated duration of 1 pass of the main loop (see lnsim.c)
+#define MAIN_LOOP_CYCLES SIM_US(250)
+
+// a client
+
+typedef struct {
+    int fd;
+    unsigned id;
+    char line[CLIENT_LINE];
+    size_t length;
+} client_t;
+
+// a LN message of a client that waits for the line
+
+typedef struct {
+    unsigned client;
+    uint8_t msg[LN_MSG_MAX];
+    uint8_t length;
+    uint64_t time;
+} pending_t;
+
+// variables
+static bool quiet;
+static volatile sig_atomic_t stop;
+static client_t clients[MAX_CLIENTS];
+static unsigned nextClientId = 1;
+static pending_t pending[MAX_PENDING];
+static unsigned pendingHead;
+static unsigned pendingCount;
+static bool inFlight;
+static bool onLine;
+static uint8_t lineMsg[LN_MSG_MAX];
+static uint8_t lineLength;
+static uint8_t lineFlags;
+// results
+static unsigned long sentOk;
+static unsigned long sentError;
+static unsigned long boardMessages;
+static uint64_t totalLatency;
+static uint64_t maxLatency;
+
+// <editor-fold defaultstate="collapsed" desc="clients">
+
+/**
+ * close the connection of a client
+ * @param client: the client
+ * @param reason: the reason (printed)
+ */
+static void closeClient(client_t* client, const char* reason)
+{
+    if (!quiet)
+    {
+        fprintf(stderr, "lnserver: client %u %s\n", client->id, reason);
+    }
+    close(client->fd);
+    client->fd = -1;
+}
+
+/**
+ * send a line to a client (a client that does not read is closed, the
+ * virtual clock does not wait for it)
+ * @param client: the client
+ * @param text: the line (without end of line)
+ */
+static void sendLine(client_t* client, const char* text)
+{
+    char line[CLIENT_LINE];
+    int length = snprintf(line, sizeof (line), "%s\r\n", text);
+
+    if (client->fd < 0)
+    {
+        return;
+    }
+    if (send(client->fd, line, (size_t) length, MSG_NOSIGNAL | MSG_DONTWAIT)
+            != length)
+    {
+        closeClient(client, "does not read, closed");
+    }
+}
+
+/**
+ * send a line to the client with an id (if it is still connected)
+ * @param id: the id of the client
+ * @param text: the line
+ */
+static void sendLineTo(unsigned id, const char* text)
+{
+    for (unsigned i = 0; i < MAX_CLIENTS; i++)
+    {
+        if ((clients[i].fd >= 0) && (clients[i].id == id))
+        {
+            sendLine(&clients[i], text);
+        }
+    }
+}
+
+/**
+ * handle a command of a client
+ * @param client: the client
+ * @param command: the command (1 line)
+ */
+static void handleCommand(client_t* client, const char* command)
+{
+    uint8_t msg[LN_MSG_MAX];
+
+    if (strncmp(command, "SEND", 4) != 0)
+    {
+        // only SEND is a command of the LbServer protocol
+        return;
+    }
+    uint8_t length = lnMsgParse(msg, command + 4);
+    if ((length < 2) || (length != lnMsgLength(msg)) ||
+            !lnMsgIsChecksumCorrect(msg, length))
+    {
+        sendLine(client, "SENT ERROR invalid message");
+        sentError++;
+        return;
+    }
+    if (pendingCount == MAX_PENDING)
+    {
+        sendLine(client, "SENT ERROR busy");
+        sentError++;
+        return;
+    }
+    pending_t* entry = &pending[(pendingHead + pendingCount) % MAX_PENDING];
+    entry->client = client->id;
+    memcpy(entry->msg, msg, length);
+    entry->length = length;
+    entry->time = simNow();
+    pendingCount++;
+}
+
+/**
+ * read the commands of a client
+ * @param client: the client
+ */
+static void readClient(client_t* client)
+{
+    ssize_t n = recv(client->fd, client->line + client->length,
+            CLIENT_LINE - 1 - client->length, 0);
+
+    if (n <= 0)
+    {
+        closeClient(client, "disconnected");
+        return;
+    }
+    client->length += (size_t) n;
+    client->line[client->length] = '\0';
+    char* start = client->line;
+    char* end;
+    while ((end = strpbrk(start, "\r\n")) != 0)
+    {
+        *end = '\0';
+        handleCommand(client, start);
+        if (client->fd < 0)
+        {
+            return;
+        }
+        start = end + 1;
+    }
+    client->length = strlen(start);
+    memmove(client->line, start, client->length + 1);
+    if (client->length == CLIENT_LINE - 1)
+    {
+        // a line without end is ignored
+        client->length = 0;
+    }
+}
+
+/**
+ * accept a new client
+ * @param server: the socket of the server
+ */
+static void acceptClient(int server)
+{
+    int fd = accept(server, 0, 0);
+
+    if (fd < 0)
+    {
+        return;
+    }
+    for (unsigned i = 0; i < MAX_CLIENTS; i++)
+    {
+        client_t* client = &clients[i];
+        if (client->fd < 0)
+        {
+            client->fd = fd;
+            client->id = nextClientId++;
+            client->length = 0;
+            if (!quiet)
+            {
+                fprintf(stderr, "lnserver: client %u connected\n",
+                        client->id);
+            }
+            sendLine(client, "VERSION lnserver (simulated board)");
+            return;
+        }
+    }
+    close(fd);
+}
+
+/**
+ * wait for the sockets and handle the clients
+ * @param server: the socket of the server
+ * @param timeout: the maximum time to wait (in ms)
+ */
+static void pollClients(int server, int timeout)
+{
+    struct pollfd fds[MAX_CLIENTS + 1];
+    client_t* owners[MAX_CLIENTS + 1];
+    nfds_t count = 0;
+
+    fds[count].fd = server;
+    fds[count].events = POLLIN;
+    owners[count++] = 0;
+    for (unsigned i = 0; i < MAX_CLIENTS; i++)
+    {
+        if (clients[i].fd >= 0)
+        {
+            fds[count].fd = clients[i].fd;
+            fds[count].events = POLLIN;
+            owners[count++] = &clients[i];
+        }
+    }
+    if (poll(fds, count, timeout) <= 0)
+    {
+        return;
+    }
+    for (nfds_t i = 0; i < count; i++)
+    {
+        if (!(fds[i].revents & (POLLIN | POLLHUP | POLLERR)))
+        {
+            continue;
+        }
+        if (owners[i] == 0)
+        {
+            acceptClient(server);
+        }
+        else if (owners[i]->fd >= 0)
+        {
+            readClient(owners[i]);
+        }
+    }
+}
+
+// </editor-fold>
+
+// <editor-fold defaultstate="collapsed" desc="LN line">
+
+/**
+ * hook for all bytes on the LN line, send the complete messages to all
+ * clients (RECEIVE)
+ * @param value: the byte on the LN line
+ * @param flags: the source of the byte
+ */
+static void lineHook(uint8_t value, uint8_t flags)
+{
+    char text[8 + (LN_MSG_MAX * 3)];
+
+    if (flags & SIM_LINE_BREAK)
+    {
+        lineLength = 0;
+        return;
+    }
+    if (value & 0x80)
+    {
+        lineLength = 0;
+        lineFlags = 0;
+    }
+    if (lineLength < LN_MSG_MAX)
+    {
+        lineMsg[lineLength++] = value;
+        lineFlags |= flags;
+    }
+    if ((lineLength < 2) || (lineLength != lnMsgLength(lineMsg)))
+    {
+        return;
+    }
+    int length = snprintf(text, sizeof (text), "RECEIVE");
+    for (uint8_t i = 0; i < lineLength; i++)
+    {
+        length += snprintf(text + length, sizeof (text) - (size_t) length,
+                " %02X", lineMsg[i]);
+    }
+    for (unsigned i = 0; i < MAX_CLIENTS; i++)
+    {
+        sendLine(&clients[i], text);
+    }
+    if (lineFlags & SIM_LINE_LOCAL)
+    {
+        boardMessages++;
+    }
+    // the LN message in flight is on the line as sent
+    pending_t* entry = &pending[pendingHead];
+    if (inFlight && (lineFlags == SIM_LINE_EXTERNAL) &&
+            (lineLength == entry->length) &&
+            (memcmp(lineMsg, entry->msg, lineLength) == 0))
+    {
+        onLine = true;
+    }
+    if (!quiet)
+    {
+        lnMsgFormat(text, sizeof (text), lineMsg, lineLength);
+        fprintf(stderr, "%10.3f ms  %s %s\n", simNow() / (double) SIM_MS(1),
+                (lineFlags & SIM_LINE_LOCAL) ? "board" : "ext  ", text);
+    }
+    lineLength = 0;
+}
+
+/**
+ * give the next LN message of the clients to the external device, when the
+ * LN message in flight is sent (1 LN message at a time, so every client
+ * gets the result of its own LN message)
+ */
+static void feedLine(void)
+{
+    if (!simIsExternalIdle())
+    {
+        return;
+    }
+    if (inFlight)
+    {
+        pending_t* entry = &pending[pendingHead];
+        if (onLine)
+        {
+            uint64_t latency = simNow() - entry->time;
+            totalLatency += latency;
+            maxLatency = (latency > maxLatency) ? latency : maxLatency;
+            sentOk++;
+        }
+        else
+        {
+            sentError++;
+        }
+        sendLineTo(entry->client, onLine ? "SENT OK" :
+                "SENT ERROR collision");
+        pendingHead = (pendingHead + 1) % MAX_PENDING;
+        pendingCount--;
+        inFlight = false;
+    }
+    if (pendingCount > 0)
+    {
+        pending_t* entry = &pending[pendingHead];
+        simSendMessage(entry->msg, entry->length);
+        inFlight = true;
+        onLine = false;
+    }
+}
+
+// </editor-fold>
+
+/**
+ * stop the server (signal handler)
+ */
+static void stopServer(int number)
+{
+    stop = 1;
+}
+
+/**
+ * get the time of the host
+ * @return the time (in s)
+ */
+static double getTime(void)
+{
+    struct timespec now;
+
+    clock_gettime(CLOCK_MONOTONIC, &now);
+    return (double) now.tv_sec + (now.tv_nsec / 1e9);
+}
+
+/**
+ * main (start of program)
+ */
+int main(int argc, char** argv)
+{
+    uint8_t address = 1;
+    unsigned port = DEFAULT_PORT;
+    double speed = 1.0;
+    int option;
+
+    while ((option = getopt(argc, argv, "a:p:x:q")) != -1)
+    {
+        switch (option)
+        {
+            case 'a':
+                address = (uint8_t) strtoul(optarg, 0, 0);
+                break;
+            case 'p':
+                port = (unsigned) strtoul(optarg, 0, 0);
+                break;
+            case 'x':
+                speed = strtod(optarg, 0);
+                break;
+            case 'q':
+                quiet = true;
+                break;
+            default:
+                fprintf(stderr, "usage: %s [-a address] [-p port] "
+                        "[-x speed] [-q]\n", argv[0]);
+                return 1;
+        }
+    }
+    if ((port < 1) || (port > 65535) || (speed < 0))
+    {
+        fprintf(stderr, "%s: 1 <= port <= 65535, speed >= 0\n", argv[0]);
+        return 1;
+    }
+
+    // the socket of the server (localhost only)
+    int server = socket(AF_INET, SOCK_STREAM, 0);
+    int on = 1;
+    struct sockaddr_in local;
+    memset(&local, 0, sizeof (local));
+    local.sin_family = AF_INET;
+    local.sin_port = htons((uint16_t) port);
+    local.sin_addr.s_addr = htonl(INADDR_LOOPBACK);
+    if ((server < 0) ||
+            (setsockopt(server, SOL_SOCKET, SO_REUSEADDR, &on, sizeof (on))
+            < 0) ||
+            (bind(server, (struct sockaddr*) &local, sizeof (local)) < 0) ||
+            (listen(server, MAX_CLIENTS) < 0))
+    {
+        perror("lnserver");
+        return 1;
+    }
+    for (unsigned i = 0; i < MAX_CLIENTS; i++)
+    {
+        clients[i].fd = -1;
+    }
+    struct sigaction action;
+    memset(&action, 0, sizeof (action));
+    action.sa_handler = &stopServer;
+    sigaction(SIGINT, &action, 0);
+    sigaction(SIGTERM, &action, 0);
+
+    // power up the board
+    simReset();
+    simSetDipAddress(address);
+    simSetLineHook(&lineHook);
+    init();
+    if (!quiet)
+    {
+        fprintf(stderr, "lnserver: board %u on localhost:%u\n", address, port);
+    }
+
+    // run the main loop of the firmware, the virtual clock follows the host
+    // clock (or runs as fast as possible)
+    double start = getTime();
+    uint64_t begin = simNow();
+    while (!stop)
+    {
+        updateLeds();
+        lnRxRingHandler();
+        lnTxPendingHandler();
+        dipSwitchHandler();
+        feedLine();
+        simRun(MAIN_LOOP_CYCLES);
+        int timeout = 0;
+        if (speed > 0)
+        {
+            double ahead = (double) (simNow() - begin) / (double) SIM_MS(1000)
+                    / speed - (getTime() - start);
+            timeout = (ahead > 0.001) ? (int) (ahead * 1000.0) : 0;
+        }
+        pollClients(server, timeout);
+    }
+
+    double seconds = (double) (simNow() - begin) / (double) SIM_MS(1000);
+    printf("virtual time %.3f s, %lu LN messages of the clients sent (%lu "
+            "errors), %lu LN messages of the board\n", seconds, sentOk,
+            sentError, boardMessages);
+    if (sentOk > 0)
+    {
+        printf("SEND till SENT OK (virtual time): avg %.2f ms, max %.2f ms\n",
+                (double) totalLatency / (double) sentOk / (double) SIM_MS(1),
+                (double) maxLatency / (double) SIM_MS(1));
+    }
+    for (unsigned i = 0; i < MAX_CLIENTS; i++)
+    {
+        if (clients[i].fd >= 0)
+        {
+            close(clients[i].fd);
+        }
+    }
+    close(server);
+    return 0;
+}
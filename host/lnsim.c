@@ -0,0 +1,620 @@
+/*
+ * file: lnsim.c
+ * author: J. van Hooydonk
+ * comments: host program, runs the firmware on the simulated device
+ *
+ * usage: lnsim [-a address] [-t seconds] [-q] [-m] [-s] [-p] [-i] [-r] [-l]
+ *  -a: the DIP switch address of the board (default 1)
+ *  -t: the virtual time to run after the scenario (default 5)
+ *  -q: quiet, do not print the LN messages
+ *  -m: print the RAM used by the LN queues (on the PIC18) and exit
+ *  -s: read the LN statistics of the board with peer transfers at the end
+ *  -p: read the ISR profile of the board with peer transfers at the end
+ *      (only lnsim_profile, the firmware built with ISR_PROFILE)
+ *  -i: interrogate the board at the end (OPC_SW_STATE of every turnout and
+ *      the interrogate sequence of a command station)
+ *  -r: read the LN trace of the board with peer transfers at the end
+ *      (only lnsim_trace, the firmware built with LN_TRACE), the replies
+ *      are printed like all LN traffic, decode them with lntrace
+ *  -l: read the latency histograms of the board with peer transfers at the
+ *      end and compare them with the latency on the line (from the end of
+ *      the command till the end of the report, measured by the host)
+ *      (only lnsim_latency, the firmware built with CMD_LATENCY)
+ *
+ * the board is powered up, receives a switch request for all turnouts and
+ * an aspect for all signals, and all LN traffic is printed with its
+ * (virtual) time stamp
+ *
+ * revision history:
+ *  v1.0 Creation (16/10/2026)
+ *  v1.1 RAM report of the LN queues (16/10/2026)
+ *  v1.2 LN statistics (16/10/2026)
+ *  v1.3 ISR profile (16/10/2026)
+ *  v1.4 the received LN messages are handled in the main loop (16/10/2026)
+ *  v1.5 interrogate (16/10/2026)
+ *  v1.6 LN trace (16/10/2026)
+ *  v1.7 no LN TX temp and comp queue in the RAM report (16/10/2026)
+ *  v1.8 latency from a command to its feedback (16/10/2026)
+ *  v1.9 the pending LN messages are retried in the main loop (16/10/2026)
+ *  v1.10 the DIP switch address is debounced in the main loop (16/10/2026)
+ *  v1.11 the RAM of the LN RX ring counts the entry of a slot (16/10/2026)
+ *  v1.12 the latency on the line ends with the report of the commanded end
+ *        state (16/10/2026)
+ */
+
+#define _POSIX_C_SOURCE 200809L
+
+#include <stdio.h>
+#include <stdlib.h>
+#include <time.h>
+#include <unistd.h>
+#include "firmware.c"
+#include "pic18_sim.h"
+#include "ln_msg.h"
+
+// definitions
+// estimated duration of 1 pass of the main loop (updateLeds)
+#define MAIN_LOOP_CYCLES SIM_US(250)
+// source address of the simulated PC that reads the LN statistics
+#define STATS_SRC 0x50
+// RAM of the header of a queue on the PIC18 (5 bytes + 16 bit data pointer)
+#define PIC18_QUEUE_HEADER 7U
+// RAM of the LN RX message slot ring on the PIC18 (head, tail and per slot
+// length, entry and values)
+#define PIC18_RX_RING (2U + LN_RX_SLOTS * (2U + LN_RX_SLOT_SIZE))
+
+// variables
+static bool quiet;
+static uint8_t lineMsg[LN_MSG_MAX];
+static uint8_t lineLength;
+static uint8_t lineFlags;
+#ifdef ISR_PROFILE
+// the ISR profile pages received from the board
+static uint16_t profileValues[PROFILE_SOURCES][LN_PROFILE_PAGES][3];
+static bool profileReceived[PROFILE_SOURCES][LN_PROFILE_PAGES];
+
+/**
+ * store a page of the ISR profile (a peer transfer of the board)
+ * @param msg: the LN message
+ * @param length: the length of the LN message
+ */
+static void storeProfile(const uint8_t* msg, uint8_t length)
+{
+    uint8_t d[8];
+
+    if (!lnMsgPeerXferData(d, msg, length) ||
+            ((d[0] & 0xf0) != LN_PROFILE_REPLY))
+    {
+        return;
+    }
+    uint8_t page = d[0] & 0x0f;
+    uint8_t source = d[7];
+    if ((source < PROFILE_SOURCES) && (page < LN_PROFILE_PAGES))
+    {
+        for (uint8_t i = 0; i < 3; i++)
+        {
+            profileValues[source][page][i] =
+                    (uint16_t) (d[1 + (i * 2)] | (d[2 + (i * 2)] << 8));
+        }
+        profileReceived[source][page] = true;
+    }
+}
+
+/**
+ * print the ISR profile that was read from the board (times in us)
+ */
+static void printProfile(void)
+{
+    static const char* names[PROFILE_SOURCES] = {
+        "isrHigh", "isrLow", "servoIsrCcp1", "lnIsrTmr1", "lnIsrTx",
+        "lnIsrRc", "servoIsrTmr3", "sIsrTmr3"
+    };
+
+    printf("\nISR profile (us, host clock), histogram bins < 25/50/100/200/"
+            "400/more us\n");
+    printf("%-14s %8s %8s %8s  %s\n", "source", "min", "avg", "max",
+            "histogram");
+    for (uint8_t i = 0; i < PROFILE_SOURCES; i++)
+    {
+        bool complete = true;
+        for (uint8_t page = 0; page < LN_PROFILE_PAGES; page++)
+        {
+            complete = complete && profileReceived[i][page];
+        }
+        if (!complete)
+        {
+            printf("%-14s (no reply)\n", names[i]);
+            continue;
+        }
+        uint16_t* values = profileValues[i][0];
+        if ((profileValues[i][1][0] | profileValues[i][1][1] |
+                profileValues[i][1][2] | profileValues[i][2][0] |
+                profileValues[i][2][1] | profileValues[i][2][2]) == 0)
+        {
+            printf("%-14s (not called)\n", names[i]);
+            continue;
+        }
+        printf("%-14s %8.2f %8.2f %8.2f ", names[i],
+                values[0] / (double) PROFILE_TICKS_PER_US,
+                values[1] / (double) PROFILE_TICKS_PER_US,
+                values[2] / (double) PROFILE_TICKS_PER_US);
+        for (uint8_t page = 1; page < LN_PROFILE_PAGES; page++)
+        {
+            for (uint8_t j = 0; j < 3; j++)
+            {
+                printf(" %u", profileValues[i][page][j]);
+            }
+        }
+        printf("\n");
+    }
+}
+
+#endif
+#ifdef CMD_LATENCY
+#define LATENCY_HISTOGRAMS (LATENCY_CHANNELS * LATENCY_STAGES)
+// the latency pages received from the board
+static uint16_t latencyValues[LATENCY_HISTOGRAMS][LN_LATENCY_PAGES][3];
+static bool latencyReceived[LATENCY_HISTOGRAMS][LN_LATENCY_PAGES];
+// the latency on the line per channel (in cycles)
+static uint64_t lineCommandTime[LATENCY_CHANNELS];
+static bool lineCommandOpen[LATENCY_CHANNELS];
+// status bits of the report of the commanded end state (SN2 or IN2)
+static uint8_t lineTarget[LATENCY_CHANNELS];
+static unsigned lineCount[LATENCY_CHANNELS];
+static uint64_t lineMax[LATENCY_CHANNELS];
+
+/**
+ * store a page of a latency histogram (a peer transfer of the board)
+ * @param msg: the LN message
+ * @param length: the length of the LN message
+ */
+static void storeLatency(const uint8_t* msg, uint8_t length)
+{
+    uint8_t d[8];
+
+    if (!lnMsgPeerXferData(d, msg, length) ||
+            ((d[0] & 0xf0) != LN_LATENCY_REPLY))
+    {
+        return;
+    }
+    uint8_t page = d[0] & 0x0f;
+    uint8_t histogram = d[7];
+    if ((histogram < LATENCY_HISTOGRAMS) && (page < LN_LATENCY_PAGES))
+    {
+        for (uint8_t i = 0; i < 3; i++)
+        {
+            latencyValues[histogram][page][i] =
+                    (uint16_t) (d[1 + (i * 2)] | (d[2 + (i * 2)] << 8));
+        }
+        latencyReceived[histogram][page] = true;
+    }
+}
+
+/**
+ * measure the latency on the line, with the same rules as the board (refer
+ * to latency.c): a command that changes the feedback starts the measurement
+ * of its channel, the report of the commanded end state ends it
+ * @param msg: the LN message
+ * @param local: true if the board transmitted the LN message
+ */
+static void measureLatency(const uint8_t* msg, bool local)
+{
+    uint8_t index = msg[1] & 0x07;
+    bool board = ((msg[1] & 0x78) == lnSwKey1) &&
+            ((msg[2] & 0x0f) == lnSwKey2);
+    uint8_t channel;
+    uint8_t target;
+    bool reached;
+
+    if (!local && board && (msg[0] == 0xb0))
+    {
+        channel = LATENCY_AW + index;
+        // C = KAWL (0x20) or T = KAWR (0x10)
+        target = (msg[2] & 0x20) ? 0x20 : 0x10;
+        reached = (msg[2] & 0x20) ? awList[index].KAWL : awList[index].KAWR;
+    }
+    else if (!local && (msg[0] == 0xed) && ((msg[5] & 0x3e) == lnImKey1) &&
+            ((msg[6] & 0x70) == lnImKey2))
+    {
+        index = (uint8_t) (((msg[5] & 0x01) << 2) | ((msg[6] >> 1) & 0x03));
+        channel = LATENCY_S + index;
+        // L = KFS (0x10) for aspect R, else L = 0 (KOS)
+        target = ((msg[7] == 0) || (msg[7] == 18)) ? 0x10 : 0x00;
+        reached = ((msg[7] == 0) || (msg[7] == 18)) ?
+                sList[index].KFS : sList[index].KOS;
+    }
+    else if ((local && board && (msg[0] == 0xb1) && (msg[2] & 0x30)) ||
+            (local && board && (msg[0] == 0xb2) &&
+            (sList[index].KOS || sList[index].KFS)))
+    {
+        channel = ((msg[0] == 0xb1) ? LATENCY_AW : LATENCY_S) + index;
+        uint8_t status = msg[2] & ((msg[0] == 0xb1) ? 0x30 : 0x10);
+        if (lineCommandOpen[channel] && (status == lineTarget[channel]))
+        {
+            uint64_t latency = simNow() - lineCommandTime[channel];
+            lineCount[channel]++;
+            if (latency > lineMax[channel])
+            {
+                lineMax[channel] = latency;
+            }
+            lineCommandOpen[channel] = false;
+        }
+        return;
+    }
+    else
+    {
+        return;
+    }
+    lineCommandTime[channel] = simNow();
+    lineTarget[channel] = target;
+    lineCommandOpen[channel] = !reached;
+}
+
+/**
+ * print the latency histograms that were read from the board and the latency
+ * on the line (times in ms)
+ */
+static void printLatency(void)
+{
+    static const char* stages[LATENCY_STAGES] = {"confirm", "report"};
+
+    printf("\ncommand latency (ms), histogram bins < 50/100/250/500/1000/2000/"
+            "4000/more ms, line = host\n");
+    printf("%-8s %-8s %6s %8s  %-26s %6s %8s\n", "channel", "stage", "count",
+            "max", "histogram", "line", "max");
+    for (uint8_t i = 0; i < LATENCY_HISTOGRAMS; i++)
+    {
+        uint8_t channel = i / LATENCY_STAGES;
+        uint8_t stage = i % LATENCY_STAGES;
+        char name[8];
+        snprintf(name, sizeof (name), "%s %u",
+                (channel < LATENCY_S) ? "AW" : "S", channel % 8);
+        bool complete = true;
+        for (uint8_t page = 0; page < LN_LATENCY_PAGES; page++)
+        {
+            complete = complete && latencyReceived[i][page];
+        }
+        if (!complete)
+        {
+            printf("%-8s %-8s (no reply)\n", name, stages[stage]);
+            continue;
+        }
+        // max, bins 0 - 7
+        uint16_t* values = latencyValues[i][0];
+        unsigned count = 0;
+        for (uint8_t j = 1; j <= LATENCY_BINS; j++)
+        {
+            count += values[j];
+        }
+        if ((count == 0) && (lineCount[channel] == 0))
+        {
+            continue;
+        }
+        printf("%-8s %-8s %6u %8.1f ", name, stages[stage], count,
+                values[0] * (LATENCY_US_PER_TICK / 1000.0));
+        for (uint8_t j = 1; j <= LATENCY_BINS; j++)
+        {
+            printf(" %2u", values[j]);
+        }
+        if (stage == LATENCY_REPORT)
+        {
+            printf("  %6u %8.1f", lineCount[channel],
+                    lineMax[channel] / (double) SIM_MS(1));
+        }
+        printf("\n");
+    }
+}
+
+#endif
+
+/**
+ * hook for all bytes on the LN line, print the complete messages
+ * @param value: the byte on the LN line
+ * @param flags: the source of the byte
+ */
+static void lineHook(uint8_t value, uint8_t flags)
+{
+    char text[160];
+
+    if (flags & SIM_LINE_BREAK)
+    {
+        lineLength = 0;
+        if (!quiet)
+        {
+            printf("%10.3f ms  -- linebreak\n", simNow() / (double) SIM_MS(1));
+        }
+        return;
+    }
+    if (value & 0x80)
+    {
+        lineLength = 0;
+        lineFlags = 0;
+    }
+    if (lineLength < LN_MSG_MAX)
+    {
+        lineMsg[lineLength++] = value;
+        lineFlags |= flags;
+    }
+    if ((lineLength >= 2) && (lineLength == lnMsgLength(lineMsg)))
+    {
+        if (!quiet)
+        {
+            lnMsgFormat(text, sizeof (text), lineMsg, lineLength);
+            printf("%10.3f ms  %s %s%s\n", simNow() / (double) SIM_MS(1),
+                    (lineFlags & SIM_LINE_LOCAL) ? "board" : "ext  ", text,
+                    lnMsgIsChecksumCorrect(lineMsg, lineLength) ?
+                    "" : " (checksum error)");
+        }
+#ifdef ISR_PROFILE
+        storeProfile(lineMsg, lineLength);
+#endif
+#ifdef CMD_LATENCY
+        if (lnMsgIsChecksumCorrect(lineMsg, lineLength))
+        {
+            storeLatency(lineMsg, lineLength);
+            measureLatency(lineMsg, (lineFlags & SIM_LINE_LOCAL) != 0);
+        }
+#endif
+        lineLength = 0;
+    }
+}
+
+/**
+ * run the main loop of the firmware
+ * @param cycles: the (virtual) time to run
+ */
+static void runMainLoop(uint64_t cycles)
+{
+    uint64_t end = simNow() + cycles;
+
+    while (simNow() < end)
+    {
+        updateLeds();
+        lnRxRingHandler();
+        lnTxPendingHandler();
+        dipSwitchHandler();
+        simRun(MAIN_LOOP_CYCLES);
+    }
+}
+
+/**
+ * print the RAM used by the LN queues on the PIC18
+ */
+static void printRamReport(void)
+{
+    static const struct {
+        const char* name;
+        unsigned size;
+    } queues[] = {
+        {"lnTxQueue[high]", LN_TX_QUEUE_SIZE},
+        {"lnTxQueue[low]", LN_TX_QUEUE_SIZE},
+    };
+    unsigned total = 0;
+
+    printf("%-16s %8s %8s\n", "queue", "capacity", "RAM");
+    for (size_t i = 0; i < sizeof (queues) / sizeof (queues[0]); i++)
+    {
+        unsigned ram = PIC18_QUEUE_HEADER + queues[i].size;
+        printf("%-16s %8u %8u\n", queues[i].name, queues[i].size, ram);
+        total += ram;
+    }
+    printf("%-16s %8u %8u\n", "lnRxRing", LN_RX_SLOTS * LN_RX_SLOT_SIZE,
+            PIC18_RX_RING);
+    total += PIC18_RX_RING;
+    printf("%-16s %8s %8u\n", "total", "", total);
+}
+
+/**
+ * main (start of program)
+ */
+int main(int argc, char** argv)
+{
+    uint8_t address = 1;
+    unsigned seconds = 5;
+    uint8_t msg[LN_MSG_MAX];
+    bool stats = false;
+    bool interrogate = false;
+#ifdef ISR_PROFILE
+    bool profile = false;
+#endif
+#ifdef LN_TRACE
+    bool trace = false;
+#endif
+#ifdef CMD_LATENCY
+    bool latency = false;
+#endif
+    int option;
+
+    while ((option = getopt(argc, argv, "a:t:qmspirl")) != -1)
+    {
+        switch (option)
+        {
+            case 'a':
+                address = (uint8_t) strtoul(optarg, 0, 0);
+                break;
+            case 't':
+                seconds = (unsigned) strtoul(optarg, 0, 0);
+                break;
+            case 'q':
+                quiet = true;
+                break;
+            case 's':
+                stats = true;
+                break;
+            case 'i':
+                interrogate = true;
+                break;
+            case 'p':
+#ifdef ISR_PROFILE
+                profile = true;
+                break;
+#else
+                fprintf(stderr, "%s: built without ISR_PROFILE, use "
+                        "lnsim_profile\n", argv[0]);
+                return 1;
+#endif
+            case 'r':
+#ifdef LN_TRACE
+                trace = true;
+                break;
+#else
+                fprintf(stderr, "%s: built without LN_TRACE, use "
+                        "lnsim_trace\n", argv[0]);
+                return 1;
+#endif
+            case 'l':
+#ifdef CMD_LATENCY
+                latency = true;
+                break;
+#else
+                fprintf(stderr, "%s: built without CMD_LATENCY, use "
+                        "lnsim_latency\n", argv[0]);
+                return 1;
+#endif
+            case 'm':
+                printRamReport();
+                return 0;
+            default:
+                fprintf(stderr, "usage: %s [-a address] [-t seconds] [-q] "
+                        "[-m] [-s] [-p] [-i] [-r] [-l]\n", argv[0]);
+                return 1;
+        }
+    }
+
+    clock_t start = clock();
+
+    // power up the board
+    simReset();
+    simSetDipAddress(address);
+    simSetLineHook(&lineHook);
+    init();
+    runMainLoop(SIM_MS(500));
+
+    // set all turnouts (alternately left and right) and open all signals
+    for (uint8_t i = 0; i < 8; i++)
+    {
+        simSendMessage(msg, lnMsgSwReq(msg, address, i, (i & 1) == 0));
+        simSendMessage(msg, lnMsgImmAspect(msg, address, i, 2));
+    }
+    runMainLoop(SIM_MS(1000) * seconds);
+
+    // ask the state of every turnout (the board replies with OPC_LONG_ACK)
+    // and interrogate like a command station at power up (the board replies
+    // with the reports of all turnouts and signals)
+    if (interrogate)
+    {
+        for (uint8_t i = 0; i < 8; i++)
+        {
+            simSendMessage(msg, lnMsgSwState(msg, address, i));
+            runMainLoop(SIM_MS(20));
+        }
+        for (uint8_t n = 0; n < 4; n++)
+        {
+            simSendMessage(msg, lnMsgInterrogate(msg, n));
+            runMainLoop(SIM_MS(50));
+        }
+    }
+
+    // read the LN statistics, 1 page at a time (like a PC that waits for
+    // the reply), the replies are printed by the line hook
+    if (stats)
+    {
+        for (uint8_t page = 0; page < LN_STATS_PAGES; page++)
+        {
+            simSendMessage(msg, lnMsgStatsRequest(msg, STATS_SRC, address,
+                    page));
+            runMainLoop(SIM_MS(50));
+        }
+    }
+#ifdef ISR_PROFILE
+    // read the ISR profile, 1 page at a time
+    if (profile)
+    {
+        for (uint8_t source = 0; source < PROFILE_SOURCES; source++)
+        {
+            for (uint8_t page = 0; page < LN_PROFILE_PAGES; page++)
+            {
+                simSendMessage(msg, lnMsgProfileRequest(msg, STATS_SRC,
+                        address, source, page));
+                runMainLoop(SIM_MS(50));
+            }
+        }
+    }
+#endif
+
+#ifdef LN_TRACE
+    // read the LN trace, 1 chunk at a time (chunk 0 freezes the trace)
+    if (trace)
+    {
+        for (uint8_t chunk = 0; chunk < LN_TRACE_CHUNKS; chunk++)
+        {
+            simSendMessage(msg, lnMsgTraceRequest(msg, STATS_SRC, address,
+                    chunk));
+            runMainLoop(SIM_MS(50));
+        }
+    }
+#endif
+
+#ifdef CMD_LATENCY
+    // read the latency histograms, 1 page at a time
+    if (latency)
+    {
+        for (uint8_t histogram = 0; histogram < LATENCY_HISTOGRAMS;
+                histogram++)
+        {
+            for (uint8_t page = 0; page < LN_LATENCY_PAGES; page++)
+            {
+                simSendMessage(msg, lnMsgLatencyRequest(msg, STATS_SRC,
+                        address, histogram, page));
+                runMainLoop(SIM_MS(50));
+            }
+        }
+    }
+#endif
+
+    double wall = (double) (clock() - start) / CLOCKS_PER_SEC;
+    double virtual = simNow() / (double) SIM_MS(1000);
+
+    // report
+    printf("\nboard %u after %.3f s (virtual)\n", address, virtual);
+    for (uint8_t i = 0; i < 8; i++)
+    {
+        printf(" %u: CAWL %u CAWR %u KAWL %u KAWR %u servo %4u  "
+                "aspect %2u KOS %u KFS %u\n", i,
+                awList[i].CAWL, awList[i].CAWR, awList[i].KAWL,
+                awList[i].KAWR, servoPortD[i], sList[i].aspect,
+                sList[i].KOS, sList[i].KFS);
+    }
+    printf("isr high %llu, isr low %llu, line bytes %llu, collisions %llu, "
+            "linebreaks %llu, overruns %llu\n",
+            (unsigned long long) simStats.isrHigh,
+            (unsigned long long) simStats.isrLow,
+            (unsigned long long) simStats.lineBytes,
+            (unsigned long long) simStats.collisions,
+            (unsigned long long) simStats.linebreaks,
+            (unsigned long long) simStats.overruns);
+    printf("LN TX attempts %u, collisions %u, drops %u, deprioritised %u, "
+            "rejected %u, high water %u/%u\n", lnStats.attempts,
+            lnStats.collisions, lnStats.drops, lnStats.deprioritised,
+            lnStats.txRejected, lnStats.txHighWater[LN_TX_PRIO_HIGH],
+            lnStats.txHighWater[LN_TX_PRIO_LOW]);
+    printf("LN RX framing errors %u, overruns %u, checksum errors %u, "
+            "dropped bytes %u, high water %u, linebreaks sent %u\n",
+            lnStats.framingErrors, lnStats.overruns, lnStats.checksumErrors,
+            lnStats.rxDroppedBytes, lnStats.rxHighWater, lnStats.linebreaks);
+    printf("wall time %.3f s, %.1fx faster than real time\n", wall,
+            (wall > 0) ? virtual / wall : 0.0);
+#ifdef ISR_PROFILE
+    if (profile)
+    {
+        printProfile();
+    }
+#endif
+#ifdef CMD_LATENCY
+    if (latency)
+    {
+        printLatency();
+    }
+#endif
+    return 0;
+}
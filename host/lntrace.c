@@ -0,0 +1,196 @@
+/*
+ * file: lntrace.c
+ * author: J. van Hooydonk
+ * comments: host program, decodes a dump of the LN trace of a board into a
+ * timeline
+ *
+ * usage: lntrace [-b board] < dump
+ *  -b: only the trace chunks of this board (default: all boards)
+ *
+ * the dump is text with the LN messages in hex (1 LN message per line, like
+ * a LN monitor), the bytes of a line start after '[' (as printed by lnsim)
+ * or at the begin of the line, the other lines are ignored
+ * the trace chunks are the peer transfers of the board with D1 = 0x60 +
+ * chunk (refer to lnTraceHandler in general.c), every chunk holds 2 entries
+ * (the oldest entries first), the timeline shows per entry the time (since
+ * the first entry), the mode of the LN driver, the event and the byte, and
+ * the LN messages on the line (the received bytes)
+ * the time stamps are 16 bit (4us), a gap of more than 262ms is not seen
+ *
+ * revision history:
+ *  v1.0 Creation (16/10/2026)
+ */
+
+#define _POSIX_C_SOURCE 200809L
+
+#include <stdio.h>
+#include <stdlib.h>
+#include <unistd.h>
+#include "ln_msg.h"
+
+// definitions (refer to trace.h)
+#define TRACE_CHUNKS 32U
+#define TRACE_ENTRIES (TRACE_CHUNKS * 2U)
+#define TRACE_EVENT_RX 0x00
+#define TRACE_EVENT_TX 0x04
+#define TRACE_EVENT_LINEBREAK 0x08
+#define TRACE_EMPTY 0x0f
+#define TRACE_US_PER_TICK 4U
+
+// entry of the trace
+typedef struct {
+    uint16_t time;
+    uint8_t data;
+    uint8_t flags;
+} traceEntry_t;
+
+// variables
+static traceEntry_t entries[TRACE_ENTRIES];
+static bool received[TRACE_CHUNKS];
+static const char* modes[] = {"IDLE", "CMP", "LINEBREAK", "TX"};
+
+/**
+ * keep the entries of a trace chunk
+ * @param msg: the LN message
+ * @param length: the length of the LN message
+ * @param board: the board (-1 = all boards)
+ */
+static void storeChunk(const uint8_t* msg, uint8_t length, int board)
+{
+    uint8_t d[8];
+
+    if ((length < 2) || (lnMsgLength(msg) != length) ||
+            !lnMsgIsChecksumCorrect(msg, length) ||
+            !lnMsgPeerXferData(d, msg, length) || ((d[0] & 0xe0) != 0x60) ||
+            ((board >= 0) && (msg[2] != board)))
+    {
+        return;
+    }
+    uint8_t chunk = d[0] & 0x1f;
+    for (uint8_t i = 0; i < 2; i++)
+    {
+        traceEntry_t* entry = &entries[(chunk * 2) + i];
+        entry->flags = (uint8_t) ((d[1] >> (i * 4)) & 0x0f);
+        entry->time = (uint16_t) (d[2 + (i * 3)] | (d[3 + (i * 3)] << 8));
+        entry->data = d[4 + (i * 3)];
+    }
+    received[chunk] = true;
+}
+
+/**
+ * print the timeline of the trace
+ */
+static void printTimeline(void)
+{
+    uint8_t msg[LN_MSG_MAX];
+    uint8_t msgLength = 0;
+    char text[160];
+    bool first = true;
+    uint16_t previous = 0;
+    unsigned long time = 0;
+
+    printf("%6s %12s %10s %-9s %-9s %s\n", "entry", "time (us)",
+            "delta (us)", "mode", "event", "byte");
+    for (unsigned i = 0; i < TRACE_ENTRIES; i++)
+    {
+        traceEntry_t* entry = &entries[i];
+        if (!received[i / 2] || (entry->flags == TRACE_EMPTY))
+        {
+            continue;
+        }
+        // the 16 bit time stamps wrap, the delta is always positive
+        unsigned long delta = first ? 0 : (uint16_t) (entry->time - previous) *
+                (unsigned long) TRACE_US_PER_TICK;
+        time += delta;
+        previous = entry->time;
+        first = false;
+
+        const char* mode = modes[entry->flags & 0x03];
+        switch (entry->flags & 0x0c)
+        {
+            case TRACE_EVENT_LINEBREAK:
+                printf("%6u %12lu %10lu %-9s %-9s %u us%s\n", i, time, delta,
+                        mode, "linebreak", entry->data * 8U,
+                        ((entry->flags & 0x03) == 3) ? " (collision)" : "");
+                msgLength = 0;
+                break;
+            case TRACE_EVENT_TX:
+                printf("%6u %12lu %10lu %-9s %-9s 0x%02x\n", i, time, delta,
+                        mode, "tx", entry->data);
+                break;
+            default:
+                printf("%6u %12lu %10lu %-9s %-9s 0x%02x\n", i, time, delta,
+                        mode, ((entry->flags & 0x03) == 3) ? "rx (echo)" :
+                        "rx", entry->data);
+                // the received bytes are the LN messages on the line
+                if (entry->data & 0x80)
+                {
+                    msgLength = 0;
+                }
+                if ((msgLength > 0) || (entry->data & 0x80))
+                {
+                    msg[msgLength++] = entry->data;
+                }
+                if ((msgLength >= 2) && (msgLength == lnMsgLength(msg)))
+                {
+                    lnMsgFormat(text, sizeof (text), msg, msgLength);
+                    printf("%53s %s%s\n", "=", text,
+                            lnMsgIsChecksumCorrect(msg, msgLength) ? "" :
+                            " (checksum error)");
+                    msgLength = 0;
+                }
+                else if (msgLength >= LN_MSG_MAX)
+                {
+                    msgLength = 0;
+                }
+                break;
+        }
+    }
+}
+
+/**
+ * main (start of program)
+ */
+int main(int argc, char** argv)
+{
+    int board = -1;
+    char line[1024];
+    uint8_t msg[LN_MSG_MAX];
+    int option;
+
+    while ((option = getopt(argc, argv, "b:")) != -1)
+    {
+        switch (option)
+        {
+            case 'b':
+                board = (int) (strtoul(optarg, 0, 0) & 0x7f);
+                break;
+            default:
+                fprintf(stderr, "usage: %s [-b board] < dump\n", argv[0]);
+                return 1;
+        }
+    }
+
+    while (fgets(line, sizeof (line), stdin))
+    {
+        storeChunk(msg, lnMsgParse(msg, line), board);
+    }
+
+    unsigned chunks = 0;
+    for (unsigned i = 0; i < TRACE_CHUNKS; i++)
+    {
+        chunks += received[i] ? 1 : 0;
+    }
+    if (chunks == 0)
+    {
+        fprintf(stderr, "%s: no trace chunks in the dump\n", argv[0]);
+        return 1;
+    }
+    printTimeline();
+    if (chunks < TRACE_CHUNKS)
+    {
+        printf("%u of %u chunks missing\n", TRACE_CHUNKS - chunks,
+                TRACE_CHUNKS);
+    }
+    return 0;
+}
@@ -0,0 +1,226 @@
+/*
+ * file: lnxfercheck.c
+ * author: J. van Hooydonk
+ * comments: host program, checks that the peer transfers of the firmware
+ * (LN statistics, ISR profile, LN trace, latency histograms) have disjoint
+ * request and reply codes (D1), the firmware is built with ISR_PROFILE,
+ * LN_TRACE and CMD_LATENCY
+ *
+ * usage: lnxfercheck
+ *
+ * the board gets the replies of another board to a PC with the same address
+ * as the board (every reply code: statistics pages, profile pages, trace
+ * chunks 0 - 31, latency pages), the board must not answer them
+ * then the board gets every request once, it must answer each request with
+ * exactly 1 reply of the right code
+ * at last the board gets a request for trace chunk 0 only (abandoned dump),
+ * the trace must be released after LN_TRACE_RELEASE_TICKS
+ * the program fails (exit code 1) at the first wrong answer
+ *
+ * revision history:
+ *  v1.0 Creation (16/10/2026)
+ *  v1.1 release of an abandoned trace dump (16/10/2026)
+ */
+
+#define _POSIX_C_SOURCE 200809L
+
+#include <stdio.h>
+#include <stdlib.h>
+#include "firmware.c"
+#include "pic18_sim.h"
+#include "ln_msg.h"
+
+// definitions
+// estimated duration of 1 pass of the main loop (updateLeds)
+#define MAIN_LOOP_CYCLES SIM_US(250)
+// the board and the other board that sends its replies (to the board)
+#define CHECK_ADDRESS 1U
+#define CHECK_OTHER 2U
+// source address of the simulated PC
+#define CHECK_SRC 0x50
+
+// variables
+static uint8_t lineMsg[LN_MSG_MAX];
+static uint8_t lineLength;
+static uint8_t lineFlags;
+static unsigned replies;
+static uint8_t replyCode;
+
+/**
+ * hook for all bytes on the LN line, count the peer transfers of the board
+ * @param value: the byte on the LN line
+ * @param flags: the source of the byte
+ */
+static void lineHook(uint8_t value, uint8_t flags)
+{
+    if (flags & SIM_LINE_BREAK)
+    {
+        lineLength = 0;
+        return;
+    }
+    if (value & 0x80)
+    {
+        lineLength = 0;
+        lineFlags = 0;
+    }
+    if (lineLength < LN_MSG_MAX)
+    {
+        lineMsg[lineLength++] = value;
+        lineFlags |= flags;
+    }
+    if ((lineLength >= 2) && (lineLength == lnMsgLength(lineMsg)))
+    {
+        uint8_t d[8];
+        if ((lineFlags & SIM_LINE_LOCAL) &&
+                lnMsgPeerXferData(d, lineMsg, lineLength))
+        {
+            replies++;
+            replyCode = d[0];
+        }
+        lineLength = 0;
+    }
+}
+
+/**
+ * run the main loop of the firmware
+ * @param cycles: the (virtual) time to run
+ */
+static void runMainLoop(uint64_t cycles)
+{
+    uint64_t end = simNow() + cycles;
+
+    while (simNow() < end)
+    {
+        updateLeds();
+        lnRxRingHandler();
+        lnTxPendingHandler();
+        dipSwitchHandler();
+        simRun(MAIN_LOOP_CYCLES);
+    }
+}
+
+/**
+ * send a LN message to the board and count the peer transfers of the board
+ * @param msg: the LN message
+ * @param length: the length of the LN message
+ * @return the number of peer transfers of the board
+ */
+static unsigned sendMessage(const uint8_t* msg, uint8_t length)
+{
+    replies = 0;
+    simSendMessage(msg, length);
+    runMainLoop(SIM_MS(50));
+    return replies;
+}
+
+/**
+ * the board must not answer the reply of another board
+ * @param code: D1 of the reply
+ */
+static void checkReply(uint8_t code)
+{
+    uint8_t msg[LN_MSG_MAX];
+    uint8_t data[8] = {code, 0x01, 0x02, 0x03, 0x04, 0x05, 0x06, 0x07};
+
+    if (sendMessage(msg, lnMsgPeerXfer(msg, CHECK_OTHER, CHECK_ADDRESS,
+            data)) != 0)
+    {
+        printf("FAIL: the board answers the reply 0x%02x with 0x%02x\n",
+                code, replyCode);
+        exit(1);
+    }
+}
+
+/**
+ * the board must answer a request with 1 reply
+ * @param msg: the request
+ * @param length: the length of the request
+ * @param code: D1 of the expected reply
+ */
+static void checkRequest(const uint8_t* msg, uint8_t length, uint8_t code)
+{
+    unsigned count = sendMessage(msg, length);
+
+    if ((count != 1) || (replyCode != code))
+    {
+        printf("FAIL: request 0x%02x gets %u replies (0x%02x), expected 1 "
+                "reply 0x%02x\n", msg[6] | ((msg[5] & 0x01) << 7), count,
+                replyCode, code);
+        exit(1);
+    }
+}
+
+/**
+ * main (start of program)
+ */
+int main(int argc, char** argv)
+{
+    uint8_t msg[LN_MSG_MAX];
+
+    simReset();
+    simSetDipAddress(CHECK_ADDRESS);
+    simSetLineHook(&lineHook);
+    init();
+    runMainLoop(SIM_MS(500));
+
+    // the replies of another board to a PC with the address of the board
+    for (uint8_t page = 0; page < LN_STATS_PAGES; page++)
+    {
+        checkReply(LN_STATS_REPLY + page);
+    }
+    for (uint8_t page = 0; page < LN_PROFILE_PAGES; page++)
+    {
+        checkReply(LN_PROFILE_REPLY + page);
+    }
+    for (uint8_t chunk = 0; chunk < LN_TRACE_CHUNKS; chunk++)
+    {
+        checkReply(LN_TRACE_REPLY + chunk);
+    }
+    for (uint8_t page = 0; page < LN_LATENCY_PAGES; page++)
+    {
+        checkReply(LN_LATENCY_REPLY + page);
+    }
+    printf("replies of another board: OK\n");
+
+    // every request gets 1 reply
+    for (uint8_t page = 0; page < LN_STATS_PAGES; page++)
+    {
+        checkRequest(msg, lnMsgStatsRequest(msg, CHECK_SRC, CHECK_ADDRESS,
+                page), LN_STATS_REPLY + page);
+    }
+    for (uint8_t page = 0; page < LN_PROFILE_PAGES; page++)
+    {
+        checkRequest(msg, lnMsgProfileRequest(msg, CHECK_SRC, CHECK_ADDRESS,
+                0, page), LN_PROFILE_REPLY + page);
+    }
+    for (uint8_t chunk = 0; chunk < LN_TRACE_CHUNKS; chunk++)
+    {
+        checkRequest(msg, lnMsgTraceRequest(msg, CHECK_SRC, CHECK_ADDRESS,
+                chunk), LN_TRACE_REPLY + chunk);
+    }
+    for (uint8_t page = 0; page < LN_LATENCY_PAGES; page++)
+    {
+        checkRequest(msg, lnMsgLatencyRequest(msg, CHECK_SRC, CHECK_ADDRESS,
+                0, page), LN_LATENCY_REPLY + page);
+    }
+    printf("requests: OK\n");
+
+    // an abandoned dump (only chunk 0) releases the trace
+    checkRequest(msg, lnMsgTraceRequest(msg, CHECK_SRC, CHECK_ADDRESS, 0),
+            LN_TRACE_REPLY);
+    if (!lnTraceFrozen)
+    {
+        printf("FAIL: trace chunk 0 doesn't freeze the trace\n");
+        exit(1);
+    }
+    runMainLoop(SIM_MS(LN_TRACE_RELEASE_TICKS * 5U / 2U));
+    if (lnTraceFrozen)
+    {
+        printf("FAIL: the trace of an abandoned dump isn't released\n");
+        exit(1);
+    }
+    printf("abandoned trace dump: OK\n");
+
+    printf("OK: peer transfer requests and replies are disjoint\n");
+    return 0;
+}
@@ -0,0 +1,861 @@
+/*
+ * file: pic18_sim.c
+ * author: J. van Hooydonk
+ * comments: virtual time simulator of the PIC18F46Q10 peripherals
+ *
+ * revision history:
+ *  v1.0 Creation (16/10/2026)
+ *  v1.1 timer 5 on the host clock (ISR profiler) (16/10/2026)
+ *  v1.2 GIEL is cleared during isrLow (16/10/2026)
+ *  v1.3 timer 0 on the virtual clock (LN trace) (16/10/2026)
+ *  v1.4 external LN line (multi-node simulation) (16/10/2026)
+ */
+
+#define _POSIX_C_SOURCE 200809L
+
+#include <string.h>
+#include <time.h>
+#include "pic18_sim.h"
+
+// ISR routines of the firmware (see general.c)
+void isrHigh(void);
+void isrLow(void);
+
+// <editor-fold defaultstate="collapsed" desc="simulator state">
+
+typedef struct {
+    bool active;
+    uint64_t end;
+    uint8_t value;
+    uint8_t flags;
+} simFrame_t;
+
+typedef struct {
+    uint64_t now;
+    // timer prescaler counters
+    uint16_t t1Prescaler;
+    uint16_t t3Prescaler;
+    // EUSART receiver (2 level FIFO)
+    uint8_t rxFifo[2];
+    bool rxFerr[2];
+    uint8_t rxCount;
+    // EUSART transmitter (TX1REG + transmit shift register)
+    uint8_t txLatch;
+    bool txWritten;
+    uint8_t txReg;
+    bool txRegFull;
+    simFrame_t tsr;
+    // LN line
+    simFrame_t line;
+    uint64_t lineIdleSince;
+    bool lineBreak;
+    uint64_t lineBreakFerr;
+    bool lineIdle; // idle state of the external LN line
+    // external device on the LN line
+    uint8_t ext[SIM_EXT_SIZE];
+    uint16_t extHead;
+    uint16_t extTail;
+    bool extInMessage;
+    // data EEPROM
+    uint8_t eeprom[256];
+} simState_t;
+
+volatile hostSfr_t hostSfr;
+static simState_t sim;
+static simLineHook_t lineHook;
+static const simLine_t* extLine;
+
+// </editor-fold>
+
+// <editor-fold defaultstate="collapsed" desc="register access">
+
+/**
+ * read the EUSART receive register (this clears RC1IF when the FIFO is empty)
+ * @return the received byte
+ */
+uint8_t hostReadRc1reg(void)
+{
+    uint8_t value = 0;
+
+    if (sim.rxCount > 0)
+    {
+        value = sim.rxFifo[0];
+        sim.rxFifo[0] = sim.rxFifo[1];
+        sim.rxFerr[0] = sim.rxFerr[1];
+        sim.rxCount--;
+    }
+    hostSfr.rc1sta.FERR = (sim.rxCount > 0) && sim.rxFerr[0];
+    PIR3bits.RC1IF = (sim.rxCount > 0);
+    return value;
+}
+
+
+/**
+ * access the EUSART receive status register (clearing CREN clears OERR)
+ * @return the address of the register
+ */
+void* hostAccessRc1sta(void)
+{
+    if (!hostSfr.rc1sta.CREN)
+    {
+        hostSfr.rc1sta.OERR = false;
+    }
+    return (void*) &hostSfr.rc1sta;
+}
+
+/**
+ * access the NVM control register (a pending read or write is completed)
+ * @return the address of the register
+ */
+void* hostAccessNvmcon1(void)
+{
+    uint8_t address = NVMADRL;
+
+    if (hostSfr.nvmcon1.RD)
+    {
+        NVMDATL = sim.eeprom[address];
+        hostSfr.nvmcon1.RD = false;
+    }
+    if (hostSfr.nvmcon1.WR)
+    {
+        if (NVMCON0bits.NVMEN)
+        {
+            sim.eeprom[address] = NVMDATL;
+        }
+        hostSfr.nvmcon1.WR = false;
+    }
+    return (void*) &hostSfr.nvmcon1;
+}
+
+/**
+ * access the FVR control register (the FVR is ready as soon as enabled)
+ * @return the address of the register
+ */
+void* hostAccessFvrcon(void)
+{
+    hostSfr.fvrcon.FVRRDY = hostSfr.fvrcon.FVREN;
+    return (void*) &hostSfr.fvrcon;
+}
+
+/**
+ * access the HLVD control register (the HLVD is ready as soon as enabled)
+ * @return the address of the register
+ */
+void* hostAccessHlvdcon0(void)
+{
+    hostSfr.hlvdcon0.RDY = hostSfr.hlvdcon0.EN;
+    return (void*) &hostSfr.hlvdcon0;
+}
+
+/**
+ * access the timer 0 low register (reading it latches the high register in
+ * 16 bit mode), timer 0 counts the virtual clock (Fosc / 4) with its
+ * prescaler, so the LN trace has the time stamps of the virtual time
+ * @return the address of the register
+ */
+uint8_t* hostAccessTmr0l(void)
+{
+    if (hostSfr.t0con0.T0EN)
+    {
+        uint16_t ticks = (uint16_t) (sim.now >> hostSfr.t0con1.T0CKPS);
+        hostSfr.tmr0h = (uint8_t) (ticks >> 8);
+        hostSfr.tmr0l = (uint8_t) (ticks & 0xff);
+    }
+    return (uint8_t*) &hostSfr.tmr0l;
+}
+
+/**
+ * access the timer 5 low register (reading it latches the high register)
+ * the virtual time stands still while an ISR routine runs, so timer 5 counts
+ * the host clock instead (16 ticks per us): the ISR profiler measures the
+ * time of the firmware on the host, which is only a relative measure for
+ * the time on the PIC18
+ * @return the address of the register
+ */
+uint8_t* hostAccessTmr5l(void)
+{
+    if (hostSfr.t5con.ON)
+    {
+        struct timespec now;
+        clock_gettime(CLOCK_MONOTONIC, &now);
+        // 1 tick = 62.5ns
+        uint16_t ticks = (uint16_t) (((uint64_t) now.tv_sec * 16000000U) +
+                ((uint64_t) now.tv_nsec * 2U / 125U));
+        hostSfr.tmr5h = (uint8_t) (ticks >> 8);
+        hostSfr.tmr5l = (uint8_t) (ticks & 0xff);
+    }
+    return (uint8_t*) &hostSfr.tmr5l;
+}
+
+// </editor-fold>
+
+// <editor-fold defaultstate="collapsed" desc="peripherals">
+
+/**
+ * get the duration of 1 byte (start bit + 8 data bits + stop bit)
+ * @return the duration in cycles
+ */
+static uint64_t byteCycles(void)
+{
+    // BRGH = 0, BRG16 = 0: baudrate = Fosc / (64 x (SP1BRG + 1))
+    return (uint64_t) 10U * 16U * ((uint64_t) SP1BRG + 1U);
+}
+
+/**
+ * get the prescaler value of a timer
+ * @param tcon: the timer control register
+ * @return the prescaler (1, 2, 4 or 8)
+ */
+static uint16_t prescaler(volatile hostTxCON_t* tcon)
+{
+    return (uint16_t) (1U << tcon->CKPS);
+}
+
+/**
+ * get the number of cycles till a timer has counted a number of ticks
+ * @param ticks: the number of ticks
+ * @param tcon: the timer control register
+ * @param count: the prescaler counter
+ * @return the number of cycles
+ */
+static uint64_t timerCycles(uint32_t ticks, volatile hostTxCON_t* tcon, uint16_t count)
+{
+    return ticks * (uint64_t) prescaler(tcon) - count;
+}
+
+/**
+ * let a timer run for a number of cycles
+ * @param high: the high byte of the timer
+ * @param low: the low byte of the timer
+ * @param tcon: the timer control register
+ * @param count: the prescaler counter
+ * @param cycles: the number of cycles
+ * @param compare: the compare value (or a value > 0xffff if not used)
+ * @param match: set to true when the compare value is passed
+ * @return true: if the timer overflows
+ */
+static bool timerRun(volatile uint8_t* high, volatile uint8_t* low,
+        volatile hostTxCON_t* tcon, uint16_t* count, uint64_t cycles, uint32_t compare, bool* match)
+{
+    uint64_t total = *count + cycles;
+    uint32_t oldValue = ((uint32_t) * high << 8) + *low;
+    uint64_t newValue = oldValue + total / prescaler(tcon);
+
+    *count = (uint16_t) (total % prescaler(tcon));
+    *high = (uint8_t) (newValue >> 8);
+    *low = (uint8_t) newValue;
+    if (compare <= 0xffff)
+    {
+        if (((compare > oldValue) && (compare <= newValue)) ||
+                ((compare + 0x10000UL > oldValue) &&
+                (compare + 0x10000UL <= newValue)))
+        {
+            *match = true;
+        }
+    }
+    return (newValue > 0xffff);
+}
+
+/**
+ * update the receiver idle bit with the state of the LN line
+ */
+static void updateRcidl(void)
+{
+    if (extLine != 0)
+    {
+        BAUD1CONbits.RCIDL = sim.lineIdle;
+    }
+    else
+    {
+        BAUD1CONbits.RCIDL = !sim.lineBreak && !sim.line.active;
+    }
+}
+
+/**
+ * put a byte on the LN line
+ * @param value: the byte
+ * @param flags: the source of the byte (SIM_LINE_LOCAL or SIM_LINE_EXTERNAL)
+ */
+static void lineStart(uint8_t value, uint8_t flags)
+{
+    if (extLine != 0)
+    {
+        // the external line combines the bytes of all devices
+        (*extLine->start)(extLine->context, value, sim.now);
+    }
+    else if (sim.line.active)
+    {
+        // a second transmitter is active: LN is a wired-AND bus
+        sim.line.value &= value;
+        sim.line.flags |= flags;
+        simStats.collisions++;
+    }
+    else
+    {
+        sim.line.active = true;
+        sim.line.value = value;
+        sim.line.flags = flags;
+        sim.line.end = sim.now + byteCycles();
+    }
+}
+
+/**
+ * receive a byte in the EUSART (2 level FIFO)
+ * @param value: the received byte
+ * @param ferr: true if the byte has a framing error
+ */
+static void rxReceive(uint8_t value, bool ferr)
+{
+    if (!hostSfr.rc1sta.SPEN || !hostSfr.rc1sta.CREN || hostSfr.rc1sta.OERR)
+    {
+        return;
+    }
+    if (sim.rxCount == 2)
+    {
+        // the third byte is lost and the receiver stops
+        hostSfr.rc1sta.OERR = true;
+        simStats.overruns++;
+        return;
+    }
+    sim.rxFifo[sim.rxCount] = value;
+    sim.rxFerr[sim.rxCount] = ferr;
+    sim.rxCount++;
+    hostSfr.rc1sta.FERR = sim.rxFerr[0];
+    PIR3bits.RC1IF = true;
+}
+
+/**
+ * start the transmit shift register with the next byte
+ * @param value: the byte to transmit
+ */
+static void tsrStart(uint8_t value)
+{
+    sim.tsr.active = true;
+    sim.tsr.value = value;
+    sim.tsr.end = sim.now + byteCycles();
+    TX1STAbits.TRMT = false;
+    if (!sim.lineBreak)
+    {
+        lineStart(value, SIM_LINE_LOCAL);
+    }
+}
+
+/**
+ * pick up the byte the firmware has written in TX1REG
+ */
+static void txCommit(void)
+{
+    if (!sim.txWritten)
+    {
+        return;
+    }
+    sim.txWritten = false;
+    if (!sim.tsr.active)
+    {
+        tsrStart(sim.txLatch);
+    }
+    else
+    {
+        sim.txReg = sim.txLatch;
+        sim.txRegFull = true;
+        PIR3bits.TX1IF = false;
+    }
+}
+
+/**
+ * write the EUSART transmit register
+ * the written value is picked up at the next write or after the firmware
+ * routine has returned
+ * @return the address of the transmit latch
+ */
+uint8_t* hostWriteTx1reg(void)
+{
+    txCommit();
+    sim.txWritten = true;
+    if (sim.tsr.active)
+    {
+        // the byte waits in TX1REG till the shift register is empty
+        PIR3bits.TX1IF = false;
+    }
+    return &sim.txLatch;
+}
+
+/**
+ * check the TX pin for a (forced) linebreak
+ */
+static void lineCheckBreak(void)
+{
+    // the TX pin is disconnected from the EUSART and forced active
+    bool lineBreak = (RC6PPS == 0x00) && PORTCbits.RC6;
+
+    if (lineBreak && !sim.lineBreak)
+    {
+        simStats.linebreaks++;
+        if (extLine == 0)
+        {
+            // the linebreak destroys the byte on the line and the receiver
+            // detects a framing error after 1 byte time
+            sim.line.active = false;
+            sim.lineBreakFerr = sim.now + byteCycles();
+        }
+    }
+    if (!lineBreak && sim.lineBreak)
+    {
+        sim.lineIdleSince = sim.now;
+    }
+    if ((lineBreak != sim.lineBreak) && (extLine != 0))
+    {
+        // the external line delivers the framing error to all devices
+        (*extLine->setBreak)(extLine->context, lineBreak, sim.now);
+    }
+    sim.lineBreak = lineBreak;
+    updateRcidl();
+}
+
+/**
+ * get the time the external device may start the next byte
+ * @return the time (or UINT64_MAX if it has nothing to send)
+ */
+static uint64_t extStart(void)
+{
+    if (sim.extHead == sim.extTail)
+    {
+        return UINT64_MAX;
+    }
+    if (sim.extInMessage)
+    {
+        // the bytes of a message are sent back to back
+        return sim.line.active ? sim.line.end : sim.now;
+    }
+    if (sim.line.active || sim.lineBreak)
+    {
+        return UINT64_MAX;
+    }
+    return sim.lineIdleSince + SIM_EXT_GAP;
+}
+
+/**
+ * get the time of the next event of the peripherals
+ * @return the time of the next event
+ */
+static uint64_t nextEvent(void)
+{
+    uint64_t next = extStart();
+
+    if (T1CONbits.TMR1ON)
+    {
+        uint32_t value = ((uint32_t) TMR1H << 8) + TMR1L;
+        uint64_t t = sim.now + timerCycles(0x10000UL - value, &T1CONbits,
+                sim.t1Prescaler);
+        next = (t < next) ? t : next;
+    }
+    if (T3CONbits.ON)
+    {
+        uint32_t value = ((uint32_t) TMR3H << 8) + TMR3L;
+        uint64_t t = sim.now + timerCycles(0x10000UL - value, &T3CONbits,
+                sim.t3Prescaler);
+        next = (t < next) ? t : next;
+        if (CCP1CONbits.EN && (CCPR1 > value))
+        {
+            t = sim.now + timerCycles(CCPR1 - value, &T3CONbits,
+                    sim.t3Prescaler);
+            next = (t < next) ? t : next;
+        }
+    }
+    if (sim.line.active && (sim.line.end < next))
+    {
+        next = sim.line.end;
+    }
+    if (sim.tsr.active && (sim.tsr.end < next))
+    {
+        next = sim.tsr.end;
+    }
+    if (sim.lineBreak && (sim.lineBreakFerr > sim.now) &&
+            (sim.lineBreakFerr < next))
+    {
+        next = sim.lineBreakFerr;
+    }
+    return (next < sim.now) ? sim.now : next;
+}
+
+/**
+ * handle the events of the peripherals at the current time
+ */
+static void handleEvents(void)
+{
+    // end of the byte on the LN line
+    if (sim.line.active && (sim.line.end <= sim.now))
+    {
+        sim.line.active = false;
+        sim.lineIdleSince = sim.now;
+        simStats.lineBytes++;
+        rxReceive(sim.line.value, false);
+        if (lineHook != 0)
+        {
+            (*lineHook)(sim.line.value, sim.line.flags);
+        }
+    }
+    // end of the byte in the transmit shift register
+    if (sim.tsr.active && (sim.tsr.end <= sim.now))
+    {
+        sim.tsr.active = false;
+        TX1STAbits.TRMT = true;
+        if (sim.txRegFull)
+        {
+            sim.txRegFull = false;
+            PIR3bits.TX1IF = true;
+            tsrStart(sim.txReg);
+        }
+    }
+    // framing error after a linebreak
+    if (sim.lineBreak && (sim.lineBreakFerr != 0) &&
+            (sim.lineBreakFerr <= sim.now))
+    {
+        sim.lineBreakFerr = 0;
+        rxReceive(0x00, true);
+        if (lineHook != 0)
+        {
+            (*lineHook)(0x00, SIM_LINE_BREAK);
+        }
+    }
+    // next byte of the external device
+    if (extStart() <= sim.now)
+    {
+        uint8_t value = sim.ext[sim.extHead];
+
+        sim.extHead = (sim.extHead + 1) % SIM_EXT_SIZE;
+        // a message ends before the next opcode (msb = 1)
+        sim.extInMessage = (sim.extHead != sim.extTail) &&
+                ((sim.ext[sim.extHead] & 0x80) != 0x80);
+        lineStart(value, SIM_LINE_EXTERNAL);
+    }
+    updateRcidl();
+}
+
+/**
+ * let the peripherals run for a number of cycles
+ * @param cycles: the number of cycles
+ */
+static void advance(uint64_t cycles)
+{
+    uint64_t end = sim.now + cycles;
+
+    while (sim.now < end)
+    {
+        uint64_t next = nextEvent();
+        bool match = false;
+
+        if (next <= sim.now)
+        {
+            handleEvents();
+            continue;
+        }
+        uint64_t step = ((next < end) ? next : end) - sim.now;
+
+        if (T1CONbits.TMR1ON &&
+                timerRun(&TMR1H, &TMR1L, &T1CONbits, &sim.t1Prescaler, step,
+                0x10000UL, &match))
+        {
+            PIR4bits.TMR1IF = true;
+        }
+        if (T3CONbits.ON)
+        {
+            uint32_t compare = CCP1CONbits.EN ? CCPR1 : 0x10000UL;
+
+            if (timerRun(&TMR3H, &TMR3L, &T3CONbits, &sim.t3Prescaler, step,
+                    compare, &match))
+            {
+                PIR4bits.TMR3IF = true;
+            }
+            if (match)
+            {
+                PIR6bits.CCP1IF = true;
+            }
+        }
+        sim.now += step;
+        handleEvents();
+    }
+}
+
+// </editor-fold>
+
+// <editor-fold defaultstate="collapsed" desc="interrupts">
+
+/**
+ * check if an interrupt with a certain priority is pending
+ * @param high: true for high priority, false for low priority
+ * @return true: if an interrupt is pending
+ */
+static bool isPending(bool high)
+{
+    bool pending = false;
+
+    pending |= PIR2bits.HLVDIF && PIE2bits.HLVDIE && (IPR2bits.HLVDIP == high);
+    pending |= PIR3bits.RC1IF && PIE3bits.RC1IE && (IPR3bits.RC1IP == high);
+    pending |= PIR3bits.TX1IF && PIE3bits.TX1IE && (IPR3bits.TX1IP == high);
+    pending |= PIR4bits.TMR1IF && PIE4bits.TMR1IE && (IPR4bits.TMR1IP == high);
+    pending |= PIR4bits.TMR3IF && PIE4bits.TMR3IE && (IPR4bits.TMR3IP == high);
+    pending |= PIR6bits.CCP1IF && PIE6bits.CCP1IE && (IPR6bits.CCP1IP == high);
+    return pending;
+}
+
+/**
+ * check if an interrupt service routine can be called
+ * @return true: if an enabled interrupt is pending
+ */
+static bool isDispatchable(void)
+{
+    return INTCONbits.GIEH && (isPending(true) ||
+            (INTCONbits.GIEL && isPending(false)));
+}
+
+/**
+ * call the pending interrupt service routine (high priority first)
+ * @return true: if an interrupt service routine was called
+ */
+static bool dispatch(void)
+{
+    if (INTCONbits.GIEH && isPending(true))
+    {
+        simStats.isrHigh++;
+        isrHigh();
+    }
+    else if (INTCONbits.GIEH && INTCONbits.GIEL && isPending(false))
+    {
+        simStats.isrLow++;
+        // the low priority vector clears GIEL, RETFIE sets it again
+        INTCONbits.GIEL = false;
+        isrLow();
+        INTCONbits.GIEL = true;
+    }
+    else
+    {
+        return false;
+    }
+    txCommit();
+    lineCheckBreak();
+    advance(SIM_ISR_CYCLES);
+    return true;
+}
+
+// </editor-fold>
+
+// <editor-fold defaultstate="collapsed" desc="simulator routines">
+
+/**
+ * reset the device (registers, peripherals and EEPROM content)
+ */
+void simReset(void)
+{
+    memset((void*) &hostSfr, 0, sizeof (hostSfr));
+    memset(&sim, 0, sizeof (sim));
+    memset(&simStats, 0, sizeof (simStats));
+    // power-on reset values
+    IPR2bits.reg = 0xff;
+    IPR3bits.reg = 0xff;
+    IPR4bits.reg = 0xff;
+    IPR6bits.reg = 0xff;
+    PIR3bits.TX1IF = true;
+    TX1STAbits.TRMT = true;
+    BAUD1CONbits.RCIDL = true;
+    sim.lineIdle = true;
+    RC6PPS = 0x09;
+    PORTA = 0xff;
+    PORTB = 0xff;
+    PORTC = 0xff;
+    // EEPROM content (refer to config.h)
+    for (uint16_t i = 0; i < 256; i++)
+    {
+        sim.eeprom[i] = (i < 8) ? hostEepromData[i] : 0xff;
+    }
+}
+
+/**
+ * let the device run for a number of cycles (the ISR routines are called
+ * when their interrupt flags are raised)
+ * @param cycles: the number of cycles
+ */
+void simRun(uint64_t cycles)
+{
+    uint64_t end = sim.now + cycles;
+
+    while (sim.now < end)
+    {
+        txCommit();
+        lineCheckBreak();
+        if (!dispatch())
+        {
+            uint64_t next = nextEvent();
+
+            if (next <= sim.now)
+            {
+                handleEvents();
+            }
+            else
+            {
+                advance(((next < end) ? next : end) - sim.now);
+            }
+        }
+    }
+}
+
+/**
+ * let the device run till a point in time and call the interrupt service
+ * routine that is pending at that time (the virtual time passes this point
+ * by the duration of the routine), an interrupt that stays pending is
+ * called again at the next call (so an external line can run in between)
+ * @param time: the time (in cycles since reset)
+ */
+void simRunUntil(uint64_t time)
+{
+    if (sim.now < time)
+    {
+        simRun(time - sim.now);
+    }
+    if (sim.now > time)
+    {
+        return;
+    }
+    if (nextEvent() <= sim.now)
+    {
+        handleEvents();
+    }
+    txCommit();
+    lineCheckBreak();
+    dispatch();
+}
+
+/**
+ * get the time of the next event of the device
+ * @return the time (the current time if an interrupt is pending)
+ */
+uint64_t simNextEvent(void)
+{
+    if (sim.txWritten || isDispatchable())
+    {
+        return sim.now;
+    }
+    return nextEvent();
+}
+
+/**
+ * delay routine (see __delay_ms in xc.h)
+ * @param cycles: the number of cycles
+ */
+void simDelayCycles(uint64_t cycles)
+{
+    simRun(cycles);
+}
+
+/**
+ * get the virtual time
+ * @return the number of cycles since reset
+ */
+uint64_t simNow(void)
+{
+    return sim.now;
+}
+
+/**
+ * set the DIP switches of the board
+ * @param address: the address (refer to getDipSwitchAddress in general.c)
+ */
+void simSetDipAddress(uint8_t address)
+{
+    // PORTA = A3 A2 -- --  -- -- A1 A0
+    // PORTC = -- -- -- --  A7 A6 A5 A4
+    PORTA = (PORTA & 0x3c) | (address & 0x03) | ((address << 4) & 0xc0);
+    PORTC = (PORTC & 0xf0) | (address >> 4);
+}
+
+/**
+ * set the hook to observe the bytes on the LN line
+ * @param fptr: the function pointer to the hook (or 0)
+ */
+void simSetLineHook(simLineHook_t fptr)
+{
+    lineHook = fptr;
+}
+
+/**
+ * connect the device to an external LN line (shared with other devices),
+ * the line gets the transmitted bytes and the linebreaks of the device and
+ * delivers the received bytes (simLineReceive) and the idle state of the
+ * line (simLineSetIdle), the external device of the simulator is not used
+ * @param line: the external line (or 0 for the line of the simulator)
+ */
+void simSetLine(const simLine_t* line)
+{
+    extLine = line;
+    updateRcidl();
+}
+
+/**
+ * receive a byte from the external LN line
+ * @param value: the byte
+ * @param ferr: true if the byte has a framing error
+ */
+void simLineReceive(uint8_t value, bool ferr)
+{
+    simStats.lineBytes++;
+    rxReceive(value, ferr);
+    if (lineHook != 0)
+    {
+        (*lineHook)(value, ferr ? SIM_LINE_BREAK : SIM_LINE_EXTERNAL);
+    }
+}
+
+/**
+ * set the idle state of the external LN line (no byte in reception and
+ * no linebreak)
+ * @param idle: true if the line is idle
+ */
+void simLineSetIdle(bool idle)
+{
+    sim.lineIdle = idle;
+    updateRcidl();
+}
+
+/**
+ * let an external device send a LN message (with checksum)
+ * @param msg: the LN message
+ * @param length: the length of the LN message
+ * @return true: if the message was accepted
+ */
+bool simSendMessage(const uint8_t* msg, uint8_t length)
+{
+    uint16_t free = (uint16_t) ((sim.extHead + SIM_EXT_SIZE - sim.extTail - 1)
+            % SIM_EXT_SIZE);
+
+    if (length > free)
+    {
+        return false;
+    }
+    for (uint8_t i = 0; i < length; i++)
+    {
+        sim.ext[sim.extTail] = msg[i];
+        sim.extTail = (sim.extTail + 1) % SIM_EXT_SIZE;
+    }
+    return true;
+}
+
+/**
+ * check if the external device has sent all messages
+ * @return true: if the external device is idle
+ */
+bool simIsExternalIdle(void)
+{
+    return (sim.extHead == sim.extTail) && !sim.line.active;
+}
+
+/**
+ * read a byte of the data EEPROM
+ * @param address: the address
+ * @return the data
+ */
+uint8_t simEepromRead(uint8_t address)
+{
+    return sim.eeprom[address];
+}
+
+// </editor-fold>
@@ -0,0 +1,85 @@
+/*
+ * file: pic18_sim.h
+ * author: J. van Hooydonk
+ * comments: virtual time simulator of the PIC18F46Q10 peripherals
+ *
+ * the simulator drives the registers of <xc.h> (see host/xc.h) with a
+ * virtual clock, so the ISR routines of the firmware (isrHigh, isrLow) are
+ * called exactly when the hardware would raise the interrupt flags
+ * modelled peripherals: timer 1, timer 3 + CCP1 (compare), EUSART 1 with the
+ * LocoNet line (echo, collisions, linebreak), data EEPROM, DIP switch ports
+ *
+ * revision history:
+ *  v1.0 Creation (16/10/2026)
+ *  v1.1 external LN line (multi-node simulation, see lncontend.c)
+ *       (16/10/2026)
+ */
+
+// this is a guard condition so that contents of this file are not included
+// more than once
+#ifndef PIC18_SIM_H
+#define	PIC18_SIM_H
+
+#include <xc.h>
+
+// definitions
+// the virtual clock counts instruction cycles (Fosc / 4 = 16MHz, 62.5ns)
+#define SIM_CYCLES_PER_US 16U
+#define SIM_US(x) ((uint64_t) (x) * SIM_CYCLES_PER_US)
+#define SIM_MS(x) ((uint64_t) (x) * 1000U * SIM_CYCLES_PER_US)
+// estimated cost of an interrupt (context save/restore + flag tests)
+#define SIM_ISR_CYCLES 100U
+// an external device starts a new LN message after the carrier detect time
+#define SIM_EXT_GAP SIM_US(1200)
+// size of the transmit buffer of the external device
+#define SIM_EXT_SIZE 1024U
+
+// LN line hook flags
+#define SIM_LINE_LOCAL 0x01         // byte (partly) transmitted by the device
+#define SIM_LINE_EXTERNAL 0x02      // byte (partly) transmitted by others
+#define SIM_LINE_BREAK 0x04         // linebreak detected (framing error)
+
+// LN line hook definition (as function pointer)
+typedef void (*simLineHook_t)(uint8_t, uint8_t);
+
+// external LN line, shared by several simulated devices (every device is a
+// separate instance of the simulator): the device calls start when its
+// transmit shift register starts a byte and setBreak when its TX pin forces
+// a linebreak or releases it (with the context of the line and the virtual
+// time of the device)
+
+typedef struct {
+    void (*start)(void*, uint8_t, uint64_t);
+    void (*setBreak)(void*, bool, uint64_t);
+    void* context;
+} simLine_t;
+
+typedef struct {
+    uint64_t isrHigh;               // number of high priority interrupts
+    uint64_t isrLow;                // number of low priority interrupts
+    uint64_t lineBytes;             // number of bytes on the LN line
+    uint64_t collisions;            // number of overlapping bytes
+    uint64_t linebreaks;            // number of linebreaks on the LN line
+    uint64_t overruns;              // number of EUSART RX overruns
+} simStats_t;
+
+// simulator routines
+void simReset(void);
+void simRun(uint64_t);
+void simRunUntil(uint64_t);
+uint64_t simNextEvent(void);
+void simDelayCycles(uint64_t);
+uint64_t simNow(void);
+void simSetDipAddress(uint8_t);
+void simSetLineHook(simLineHook_t);
+void simSetLine(const simLine_t*);
+void simLineReceive(uint8_t, bool);
+void simLineSetIdle(bool);
+bool simSendMessage(const uint8_t*, uint8_t);
+bool simIsExternalIdle(void);
+uint8_t simEepromRead(uint8_t);
+
+// variables
+simStats_t simStats;
+
+#endif	/* PIC18_SIM_H */
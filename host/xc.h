@@ -0,0 +1,508 @@
+/*
+ * file: xc.h
+ * author: J. van Hooydonk
+ * comments: host (Linux) replacement of the XC8 <xc.h> header
+ *
+ * the special function registers (SFR) of the PIC18F46Q10 that are used by
+ * the firmware are mapped onto one plain struct (hostSfr), so the driver
+ * sources can be compiled unmodified with a native C compiler
+ * the peripherals behind these registers are modelled in pic18_sim.c
+ *
+ * revision history:
+ *  v1.0 Creation (16/10/2026)
+ *  v1.1 timer 5 (ISR profiler) (16/10/2026)
+ *  v1.2 timer 0 (LN trace) (16/10/2026)
+ */
+
+// this is a guard condition so that contents of this file are not included
+// more than once
+#ifndef XC_H
+#define	XC_H
+
+#include <stdbool.h>
+#include <stdint.h>
+
+// <editor-fold defaultstate="collapsed" desc="register layout">
+
+// 8 bit register with 8 named bits (e.g. PORTA.RA0 ... PORTA.RA7)
+#define HOST_SFR8(p) union { \
+    uint8_t reg; \
+    struct { \
+        unsigned p##0 : 1; unsigned p##1 : 1; unsigned p##2 : 1; \
+        unsigned p##3 : 1; unsigned p##4 : 1; unsigned p##5 : 1; \
+        unsigned p##6 : 1; unsigned p##7 : 1; \
+    }; \
+}
+
+// timer 1/3/5 control register
+typedef union {
+    uint8_t reg;
+    struct {
+        unsigned ON : 1;
+        unsigned RD16 : 1;
+        unsigned NOT_SYNC : 1;
+        unsigned : 1;
+        unsigned CKPS : 2;
+        unsigned : 2;
+    };
+    struct {
+        unsigned TMR1ON : 1;
+        unsigned : 7;
+    };
+    struct {
+        unsigned TMR3ON : 1;
+        unsigned : 7;
+    };
+} hostTxCON_t;
+
+// fixed voltage reference control register
+typedef union {
+    uint8_t reg;
+    struct {
+        unsigned ADFVR : 2;
+        unsigned CDAFVR : 2;
+        unsigned TSRNG : 1;
+        unsigned TSEN : 1;
+        unsigned FVRRDY : 1;
+        unsigned FVREN : 1;
+    };
+} hostFVRCON_t;
+
+typedef struct {
+    // ports
+    HOST_SFR8(RA) porta;
+    HOST_SFR8(RB) portb;
+    HOST_SFR8(RC) portc;
+    HOST_SFR8(RD) portd;
+    HOST_SFR8(RE) porte;
+    HOST_SFR8(LATA) lata;
+    HOST_SFR8(LATB) latb;
+    HOST_SFR8(LATC) latc;
+    HOST_SFR8(LATD) latd;
+    HOST_SFR8(LATE) late;
+    HOST_SFR8(TRISA) trisa;
+    HOST_SFR8(TRISB) trisb;
+    HOST_SFR8(TRISC) trisc;
+    HOST_SFR8(TRISD) trisd;
+    HOST_SFR8(TRISE) trise;
+    HOST_SFR8(ANSELA) ansela;
+    HOST_SFR8(ANSELB) anselb;
+    HOST_SFR8(ANSELC) anselc;
+    HOST_SFR8(ANSELE) ansele;
+    HOST_SFR8(WPUA) wpua;
+    HOST_SFR8(WPUB) wpub;
+    HOST_SFR8(WPUC) wpuc;
+    HOST_SFR8(SLRA) slrcona;
+
+    // peripheral pin select
+    uint8_t ra4pps;
+    uint8_t rc6pps;
+    uint8_t rx1pps;
+
+    // interrupt control
+    union {
+        uint8_t reg;
+        struct {
+            unsigned INT0EDG : 1;
+            unsigned INT1EDG : 1;
+            unsigned INT2EDG : 1;
+            unsigned : 2;
+            unsigned IPEN : 1;
+            unsigned GIEL : 1;
+            unsigned GIEH : 1;
+        };
+    } intcon;
+    union {
+        uint8_t reg;
+        struct {
+            unsigned C1IF : 1;
+            unsigned C2IF : 1;
+            unsigned : 4;
+            unsigned ZCDIF : 1;
+            unsigned HLVDIF : 1;
+        };
+        struct {
+            unsigned C1IE : 1;
+            unsigned C2IE : 1;
+            unsigned : 4;
+            unsigned ZCDIE : 1;
+            unsigned HLVDIE : 1;
+        };
+        struct {
+            unsigned C1IP : 1;
+            unsigned C2IP : 1;
+            unsigned : 4;
+            unsigned ZCDIP : 1;
+            unsigned HLVDIP : 1;
+        };
+    } pir2, pie2, ipr2;
+    union {
+        uint8_t reg;
+        struct {
+            unsigned : 4;
+            unsigned TX1IF : 1;
+            unsigned RC1IF : 1;
+            unsigned : 2;
+        };
+        struct {
+            unsigned : 4;
+            unsigned TX1IE : 1;
+            unsigned RC1IE : 1;
+            unsigned : 2;
+        };
+        struct {
+            unsigned : 4;
+            unsigned TX1IP : 1;
+            unsigned RC1IP : 1;
+            unsigned : 2;
+        };
+    } pir3, pie3, ipr3;
+    union {
+        uint8_t reg;
+        struct {
+            unsigned TMR1IF : 1;
+            unsigned TMR2IF : 1;
+            unsigned TMR3IF : 1;
+            unsigned : 5;
+        };
+        struct {
+            unsigned TMR1IE : 1;
+            unsigned TMR2IE : 1;
+            unsigned TMR3IE : 1;
+            unsigned : 5;
+        };
+        struct {
+            unsigned TMR1IP : 1;
+            unsigned TMR2IP : 1;
+            unsigned TMR3IP : 1;
+            unsigned : 5;
+        };
+    } pir4, pie4, ipr4;
+    union {
+        uint8_t reg;
+        struct {
+            unsigned CCP1IF : 1;
+            unsigned CCP2IF : 1;
+            unsigned : 6;
+        };
+        struct {
+            unsigned CCP1IE : 1;
+            unsigned CCP2IE : 1;
+            unsigned : 6;
+        };
+        struct {
+            unsigned CCP1IP : 1;
+            unsigned CCP2IP : 1;
+            unsigned : 6;
+        };
+    } pir6, pie6, ipr6;
+
+    // timer 1 and timer 3
+    uint8_t tmr1h;
+    uint8_t tmr1l;
+    uint8_t tmr1clk;
+    hostTxCON_t t1con;
+    uint8_t tmr3h;
+    uint8_t tmr3l;
+    uint8_t tmr3clk;
+    hostTxCON_t t3con;
+
+    // timer 0 (LN trace)
+    uint8_t tmr0h;
+    uint8_t tmr0l;
+    union {
+        uint8_t reg;
+        struct {
+            unsigned T0OUTPS : 4;
+            unsigned T016BIT : 1;
+            unsigned T0OUT : 1;
+            unsigned : 1;
+            unsigned T0EN : 1;
+        };
+    } t0con0;
+    union {
+        uint8_t reg;
+        struct {
+            unsigned T0CKPS : 4;
+            unsigned T0ASYNC : 1;
+            unsigned T0CS : 3;
+        };
+    } t0con1;
+
+    // timer 5 (ISR profiler)
+    uint8_t tmr5h;
+    uint8_t tmr5l;
+    uint8_t tmr5clk;
+    hostTxCON_t t5con;
+
+    // comparator (CCP1)
+    uint16_t ccpr1;
+    union {
+        uint8_t reg;
+        struct {
+            unsigned MODE : 4;
+            unsigned FMT : 1;
+            unsigned OUT : 1;
+            unsigned : 1;
+            unsigned EN : 1;
+        };
+    } ccp1con;
+    union {
+        uint8_t reg;
+        struct {
+            unsigned C1TSEL : 2;
+            unsigned C2TSEL : 2;
+            unsigned P4TSEL : 2;
+            unsigned P5TSEL : 2;
+        };
+    } ccptmrs;
+
+    // EUSART 1
+    uint8_t sp1brg;
+    union {
+        uint8_t reg;
+        struct {
+            unsigned RX9D : 1;
+            unsigned OERR : 1;
+            unsigned FERR : 1;
+            unsigned ADDEN : 1;
+            unsigned CREN : 1;
+            unsigned SREN : 1;
+            unsigned RX9 : 1;
+            unsigned SPEN : 1;
+        };
+    } rc1sta;
+    union {
+        uint8_t reg;
+        struct {
+            unsigned TX9D : 1;
+            unsigned TRMT : 1;
+            unsigned BRGH : 1;
+            unsigned SENDB : 1;
+            unsigned SYNC : 1;
+            unsigned TXEN : 1;
+            unsigned TX9 : 1;
+            unsigned CSRC : 1;
+        };
+    } tx1sta;
+    union {
+        uint8_t reg;
+        struct {
+            unsigned ABDEN : 1;
+            unsigned WUE : 1;
+            unsigned : 1;
+            unsigned BRG16 : 1;
+            unsigned SCKP : 1;
+            unsigned : 1;
+            unsigned RCIDL : 1;
+            unsigned ABDOVF : 1;
+        };
+    } baud1con;
+
+    // comparator 1 and fixed voltage reference
+    union {
+        uint8_t reg;
+        struct {
+            unsigned SYNC : 1;
+            unsigned : 3;
+            unsigned POL : 1;
+            unsigned : 1;
+            unsigned OUT : 1;
+            unsigned EN : 1;
+        };
+    } cm1con0;
+    uint8_t cm1nch;
+    uint8_t cm1pch;
+    hostFVRCON_t fvrcon;
+
+    // high/low-voltage detector
+    union {
+        uint8_t reg;
+        struct {
+            unsigned INTL : 1;
+            unsigned INTH : 1;
+            unsigned : 2;
+            unsigned RDY : 1;
+            unsigned OUT : 1;
+            unsigned : 1;
+            unsigned EN : 1;
+        };
+    } hlvdcon0;
+    union {
+        uint8_t reg;
+        struct {
+            unsigned SEL : 4;
+            unsigned : 4;
+        };
+    } hlvdcon1;
+
+    // non-volatile memory (data EEPROM)
+    union {
+        uint8_t reg;
+        struct {
+            unsigned : 7;
+            unsigned NVMEN : 1;
+        };
+    } nvmcon0;
+    union {
+        uint8_t reg;
+        struct {
+            unsigned RD : 1;
+            unsigned WR : 1;
+            unsigned : 6;
+        };
+    } nvmcon1;
+    uint8_t nvmcon2;
+    uint8_t nvmadrl;
+    uint8_t nvmadrh;
+    uint8_t nvmadru;
+    uint8_t nvmdatl;
+} hostSfr_t;
+
+// </editor-fold>
+
+// <editor-fold defaultstate="collapsed" desc="register access">
+
+// the register file of the simulated device (the members are named in lower
+// case, so they do not collide with the register macros below)
+extern volatile hostSfr_t hostSfr;
+
+// registers with a side effect on access (see pic18_sim.c)
+uint8_t hostReadRc1reg(void);
+uint8_t* hostWriteTx1reg(void);
+void* hostAccessRc1sta(void);
+void* hostAccessNvmcon1(void);
+void* hostAccessFvrcon(void);
+void* hostAccessHlvdcon0(void);
+uint8_t* hostAccessTmr0l(void);
+uint8_t* hostAccessTmr5l(void);
+
+#define PORTA hostSfr.porta.reg
+#define PORTB hostSfr.portb.reg
+#define PORTC hostSfr.portc.reg
+#define PORTD hostSfr.portd.reg
+#define PORTE hostSfr.porte.reg
+#define PORTCbits hostSfr.portc
+#define PORTEbits hostSfr.porte
+#define LATA hostSfr.lata.reg
+#define LATB hostSfr.latb.reg
+#define LATC hostSfr.latc.reg
+#define LATD hostSfr.latd.reg
+#define LATE hostSfr.late.reg
+#define LATAbits hostSfr.lata
+#define LATCbits hostSfr.latc
+#define TRISA hostSfr.trisa.reg
+#define TRISB hostSfr.trisb.reg
+#define TRISC hostSfr.trisc.reg
+#define TRISD hostSfr.trisd.reg
+#define TRISE hostSfr.trise.reg
+#define TRISAbits hostSfr.trisa
+#define TRISCbits hostSfr.trisc
+#define TRISEbits hostSfr.trise
+#define ANSELA hostSfr.ansela.reg
+#define ANSELB hostSfr.anselb.reg
+#define ANSELC hostSfr.anselc.reg
+#define ANSELE hostSfr.ansele.reg
+#define ANSELAbits hostSfr.ansela
+#define ANSELCbits hostSfr.anselc
+#define ANSELEbits hostSfr.ansele
+#define WPUA hostSfr.wpua.reg
+#define WPUB hostSfr.wpub.reg
+#define WPUC hostSfr.wpuc.reg
+#define SLRCONAbits hostSfr.slrcona
+#define RE0 PORTEbits.RE0
+#define RE1 PORTEbits.RE1
+#define RE2 PORTEbits.RE2
+
+#define RA4PPS hostSfr.ra4pps
+#define RC6PPS hostSfr.rc6pps
+#define RX1PPS hostSfr.rx1pps
+
+#define INTCONbits hostSfr.intcon
+#define PIR2bits hostSfr.pir2
+#define PIE2bits hostSfr.pie2
+#define IPR2bits hostSfr.ipr2
+#define PIR3bits hostSfr.pir3
+#define PIE3bits hostSfr.pie3
+#define IPR3bits hostSfr.ipr3
+#define PIR4bits hostSfr.pir4
+#define PIE4bits hostSfr.pie4
+#define IPR4bits hostSfr.ipr4
+#define PIR6bits hostSfr.pir6
+#define PIE6bits hostSfr.pie6
+#define IPR6bits hostSfr.ipr6
+
+#define TMR1H hostSfr.tmr1h
+#define TMR1L hostSfr.tmr1l
+#define TMR1CLK hostSfr.tmr1clk
+#define T1CON hostSfr.t1con.reg
+#define T1CONbits hostSfr.t1con
+#define TMR3H hostSfr.tmr3h
+#define TMR3L hostSfr.tmr3l
+#define TMR3CLK hostSfr.tmr3clk
+#define T3CON hostSfr.t3con.reg
+#define T3CONbits hostSfr.t3con
+#define TMR0H hostSfr.tmr0h
+#define TMR0L (*hostAccessTmr0l())
+#define T0CON0 hostSfr.t0con0.reg
+#define T0CON0bits hostSfr.t0con0
+#define T0CON1 hostSfr.t0con1.reg
+#define T0CON1bits hostSfr.t0con1
+#define TMR5H hostSfr.tmr5h
+#define TMR5L (*hostAccessTmr5l())
+#define TMR5CLK hostSfr.tmr5clk
+#define T5CON hostSfr.t5con.reg
+#define T5CONbits hostSfr.t5con
+
+#define CCPR1 hostSfr.ccpr1
+#define CCP1CONbits hostSfr.ccp1con
+#define CCPTMRSbits hostSfr.ccptmrs
+
+#define SP1BRG hostSfr.sp1brg
+#define RC1REG (hostReadRc1reg())
+#define TX1REG (*hostWriteTx1reg())
+#define RC1STAbits (*(__typeof__(hostSfr.rc1sta)*) hostAccessRc1sta())
+#define TX1STAbits hostSfr.tx1sta
+#define BAUD1CONbits hostSfr.baud1con
+
+#define CM1CON0bits hostSfr.cm1con0
+#define CM1NCH hostSfr.cm1nch
+#define CM1PCH hostSfr.cm1pch
+#define FVRCON hostSfr.fvrcon.reg
+#define FVRCONbits (*(hostFVRCON_t*) hostAccessFvrcon())
+
+#define HLVDCON0bits (*(__typeof__(hostSfr.hlvdcon0)*) hostAccessHlvdcon0())
+#define HLVDCON1bits hostSfr.hlvdcon1
+
+#define NVMCON0bits hostSfr.nvmcon0
+#define NVMCON1bits (*(__typeof__(hostSfr.nvmcon1)*) hostAccessNvmcon1())
+#define NVMCON2 hostSfr.nvmcon2
+#define NVMADRL hostSfr.nvmadrl
+#define NVMADRH hostSfr.nvmadrh
+#define NVMADRU hostSfr.nvmadru
+#define NVMDATL hostSfr.nvmdatl
+
+// </editor-fold>
+
+// <editor-fold defaultstate="collapsed" desc="compiler builtins">
+
+// virtual time, the delay routines let the simulated clock run
+void simDelayCycles(uint64_t);
+
+#define __interrupt(priority)
+#define NOP()
+#define di() (INTCONbits.GIEH = false)
+#define ei() (INTCONbits.GIEH = true)
+#define __delay_ms(x) simDelayCycles((uint64_t) (x) * (_XTAL_FREQ / 4000UL))
+#define __delay_us(x) simDelayCycles((uint64_t) (x) * (_XTAL_FREQ / 4000000UL))
+#define WRITETIMER1(x) (TMR1H = (uint8_t) ((x) >> 8), TMR1L = (uint8_t) ((x) & 0xff))
+#define WRITETIMER3(x) (TMR3H = (uint8_t) ((x) >> 8), TMR3L = (uint8_t) ((x) & 0xff))
+
+// the initial EEPROM content (refer to config.h) is picked up by the simulator
+extern const uint8_t hostEepromData[8];
+#define __EEPROM_DATA(a, b, c, d, e, f, g, h) \
+    const uint8_t hostEepromData[8] = {a, b, c, d, e, f, g, h}
+
+// </editor-fold>
+
+#endif	/* XC_H */
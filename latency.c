@@ -0,0 +1,129 @@
+/*
+ * file: latency.c
+ * author: J. van Hooydonk
+ * comments: latency from a command to its feedback, per turnout (AW) and per
+ * signal (S)
+ *
+ * revision history:
+ *  v1.0 Creation (16/10/2026)
+ *  v1.1 only the commanded end state confirms a command (16/10/2026)
+ */
+
+#include "latency.h"
+
+#ifdef CMD_LATENCY
+
+// upper limits of the histogram bins (in ticks of 2.5ms)
+const uint16_t latencyBinLimits[LATENCY_BINS - 1] = {
+    50000U / LATENCY_US_PER_TICK,
+    100000U / LATENCY_US_PER_TICK,
+    250000U / LATENCY_US_PER_TICK,
+    500000U / LATENCY_US_PER_TICK,
+    1000000UL / LATENCY_US_PER_TICK,
+    2000000UL / LATENCY_US_PER_TICK,
+    4000000UL / LATENCY_US_PER_TICK
+};
+
+/**
+ * initialisation of the histograms (no measurement is running)
+ */
+void latencyInit(void)
+{
+    for (uint8_t i = 0; i < LATENCY_CHANNELS; i++)
+    {
+        for (uint8_t j = 0; j < LATENCY_STAGES; j++)
+        {
+            latencyList[i][j].max = 0;
+            for (uint8_t k = 0; k < LATENCY_BINS; k++)
+            {
+                latencyList[i][j].bins[k] = 0;
+            }
+        }
+        latencyCommandTime[i] = 0;
+        latencyTarget[i] = 0;
+        latencyFlags[i] = 0;
+    }
+    latencyTime = 0;
+}
+
+/**
+ * a command for a channel is accepted, the measurement starts (a running
+ * measurement of the channel is restarted)
+ * a command that doesn't change the feedback (the AW or S is already in the
+ * commanded state) gets no report, so it isn't measured
+ * @param channel: the channel (LATENCY_AW + index or LATENCY_S + index)
+ * @param target: the commanded end state (LATENCY_KAWL, LATENCY_KAWR,
+ * LATENCY_KFS or LATENCY_KOS)
+ * @param state: the actual state of the channel
+ */
+void latencyCommand(uint8_t channel, uint8_t target, uint8_t state)
+{
+    if (state == target)
+    {
+        latencyFlags[channel] = 0;
+        return;
+    }
+    latencyCommandTime[channel] = latencyTime;
+    latencyTarget[channel] = target;
+    latencyFlags[channel] = LATENCY_WAIT_CONFIRM;
+}
+
+/**
+ * the feedback of a channel is changed, the command is confirmed when the
+ * channel is in the commanded end state, the states between (KAW or KOS and
+ * KFS cleared) and the other end state don't confirm
+ * @param channel: the channel (LATENCY_AW + index or LATENCY_S + index)
+ * @param state: the actual state of the channel
+ */
+void latencyConfirm(uint8_t channel, uint8_t state)
+{
+    if ((latencyFlags[channel] & LATENCY_WAIT_CONFIRM) &&
+            (state == latencyTarget[channel]))
+    {
+        latencyAdd(channel, LATENCY_CONFIRM);
+        latencyFlags[channel] = LATENCY_WAIT_REPORT;
+    }
+}
+
+/**
+ * the report of a channel has left LN (the echo is checked), the measurement
+ * ends with the report of the commanded end state
+ * @param channel: the channel (LATENCY_AW + index or LATENCY_S + index)
+ * @param state: the state in the report
+ */
+void latencyReport(uint8_t channel, uint8_t state)
+{
+    if ((latencyFlags[channel] & LATENCY_WAIT_REPORT) &&
+            (state == latencyTarget[channel]))
+    {
+        latencyAdd(channel, LATENCY_REPORT);
+        latencyFlags[channel] = 0;
+    }
+}
+
+/**
+ * add the time since the command to a histogram of a channel
+ * @param channel: the channel
+ * @param stage: the stage (see latencyStage_t)
+ */
+void latencyAdd(uint8_t channel, uint8_t stage)
+{
+    latency_t* latency = &latencyList[channel][stage];
+    uint16_t time = (uint16_t) (latencyTime - latencyCommandTime[channel]);
+
+    if (time > latency->max)
+    {
+        latency->max = time;
+    }
+    uint8_t bin = 0;
+    while ((bin < (LATENCY_BINS - 1)) && (time >= latencyBinLimits[bin]))
+    {
+        bin++;
+    }
+    if (latency->bins[bin] < 0xffff)
+    {
+        latency->bins[bin]++;
+    }
+}
+
+#endif
@@ -0,0 +1,97 @@
+/*
+ * file: latency.h
+ * author: J. van Hooydonk
+ * comments: latency from a command (OPC_SW_REQ, OPC_IMM_PACKET) to its
+ * feedback, per turnout (AW) and per signal (S)
+ *
+ * the command time and the commanded end state of a channel are taken when
+ * the LN RX handler accepts the command, the latency is added to the
+ * histogram of the channel at the confirmation (the commanded end state
+ * KAWL/KAWR or KOS/KFS is reached, stage LATENCY_CONFIRM) and when the
+ * report of that end state (OPC_SW_REP, OPC_INPUT_REP) has left LN after the
+ * echo check (stage LATENCY_REPORT), the feedback of the previous state (a
+ * pending report, a re-report) doesn't end the measurement
+ * the time is counted in ticks of timer 3 (2.5ms, the period of isrLow for
+ * the servos), a 16 bit tick counter covers 163s
+ * enable it with CMD_LATENCY (below or on the command line of the compiler),
+ * without CMD_LATENCY the LATENCY_ macros are empty (no RAM for the
+ * histograms and no OPC_SW_REP/OPC_INPUT_REP in the LN RX opcode table)
+ *
+ * revision history:
+ *  v1.0 Creation (16/10/2026)
+ *  v1.1 optional (CMD_LATENCY) (16/10/2026)
+ *  v1.2 only the commanded end state confirms a command (16/10/2026)
+ */
+
+// This is a guard condition so that contents of this file are not included
+// more than once.
+#ifndef LATENCY_H
+#define	LATENCY_H
+
+#include "config.h"
+
+// #define CMD_LATENCY
+
+// definitions
+// channels: AW 0 - 7 and S 0 - 7
+#define LATENCY_AW 0U
+#define LATENCY_S 8U
+#define LATENCY_CHANNELS 16U
+// number of histogram bins, the upper limits (in ticks of 2.5ms) are
+// 50ms, 100ms, 250ms, 500ms, 1s, 2s, 4s and more (a servo sweep takes
+// SWEEPTIME = 4s)
+#define LATENCY_BINS 8
+#define LATENCY_US_PER_TICK 2500U
+// flags of a channel (the measurement that is running)
+#define LATENCY_WAIT_CONFIRM 0x01 // command accepted, waiting for KAW/KOS/KFS
+#define LATENCY_WAIT_REPORT 0x02 // confirmed, waiting for the report on LN
+// end states of a channel (the feedback that confirms a command)
+#define LATENCY_KAWL 0x01 // AW in the left end position
+#define LATENCY_KAWR 0x02 // AW in the right end position
+#define LATENCY_KFS 0x01 // S closed (aspect R)
+#define LATENCY_KOS 0x02 // S open
+
+// stages of a command
+
+typedef enum {
+    LATENCY_CONFIRM, // command -> confirmation
+    LATENCY_REPORT, // command -> report on LN (after the echo check)
+    LATENCY_STAGES
+} latencyStage_t;
+
+// histogram of 1 stage of a channel
+
+typedef struct {
+    uint16_t max; // longest latency (ticks)
+    uint16_t bins[LATENCY_BINS]; // histogram (stops at 0xffff per bin)
+} latency_t;
+
+#ifdef CMD_LATENCY
+// count the ticks (timer 3), a command, its confirmation and its report
+#define LATENCY_TICK() latencyTime++
+#define LATENCY_COMMAND(channel, target, state) \
+    latencyCommand(channel, target, state)
+#define LATENCY_CONFIRMED(channel, state) latencyConfirm(channel, state)
+#define LATENCY_REPORTED(channel, state) latencyReport(channel, state)
+
+// routines
+void latencyInit(void);
+void latencyCommand(uint8_t, uint8_t, uint8_t);
+void latencyConfirm(uint8_t, uint8_t);
+void latencyReport(uint8_t, uint8_t);
+void latencyAdd(uint8_t, uint8_t);
+
+// variables
+latency_t latencyList[LATENCY_CHANNELS][LATENCY_STAGES];
+uint16_t latencyCommandTime[LATENCY_CHANNELS]; // time of the last command
+uint8_t latencyTarget[LATENCY_CHANNELS]; // commanded end state
+uint8_t latencyFlags[LATENCY_CHANNELS];
+uint16_t latencyTime; // ticks of 2.5ms
+#else
+#define LATENCY_TICK()
+#define LATENCY_COMMAND(channel, target, state)
+#define LATENCY_CONFIRMED(channel, state)
+#define LATENCY_REPORTED(channel, state)
+#endif
+
+#endif	/* LATENCY_H */
@@ -8,6 +8,26 @@
  *  v1.0 Merge PIC18F2525/2620/4525/4620 and PIC18F24/25/26/27/45/46/47Q10 microcontrollers (20/07/2024)
  *  v1.1 Remove PIC18F2525/2620/4525/4620 (obsolete processor)
  *  v2.0 complete rework of LocoNet driver after some major bugs
+ *  v2.1 received LN messages are stored in a message slot ring (16/10/2026)
+ *  v2.2 capacity per TX queue (16/10/2026)
+ *  v2.3 LN messages are moved as a block (enQueueSpan, deQueueSpan), the
+ *       copy with getQueueSpan is withdrawn in v2.16 (16/10/2026)
+ *  v2.4 framed LN TX queue (length + LN message) (16/10/2026)
+ *  v2.5 LN TX priority classes (16/10/2026)
+ *  v2.6 latest state wins for the LN status reports (16/10/2026)
+ *  v2.7 bounded retries, backoff and TX statistics (16/10/2026)
+ *  v2.8 seed of the random generator per board (16/10/2026)
+ *  v2.9 LN bus health statistics (16/10/2026)
+ *  v2.10 received LN messages are handled in the main loop (16/10/2026)
+ *  v2.11 opcode table, the other LN messages are skipped (16/10/2026)
+ *  v2.12 running checksum of the received LN message (16/10/2026)
+ *  v2.13 the LN TX handlers copy a complete LN message (built by the caller,
+ *        e.g. from a report template) into the LN TX queue (16/10/2026)
+ *  v2.14 transmit started by the LN TX handler, no idle polling (16/10/2026)
+ *  v2.15 optional trace of the LN bytes (16/10/2026)
+ *  v2.16 transmit from the LN TX queue with send + echo cursor (16/10/2026)
+ *  v2.17 latest state wins over both priority classes (16/10/2026)
+ *  v2.18 random generator with 1 xorshift step per draw (16/10/2026)
  */
 
 #include "ln.h"
@@ -16,20 +36,35 @@
 
 /**
  * LN initialisation
- * @param fptr: the function pointer to the (callback) LN RX message handler
+ * @param opcodes: the opcode table (the opcodes that are received with their
+ * length and (callback) LN RX message handler)
+ * @param size: the number of entries of the opcode table
  */
-void lnInit(lnRxMsgCallback_t fptr)
+void lnInit(const lnRxOpcode_t* opcodes, uint8_t size)
 {
-    // init LN RX message callback function (function pointer)
-    lnRxMsgCallback = fptr;
+    // init LN RX opcode table
+    lnRxOpcodes = opcodes;
+    lnRxOpcodesSize = size;
+    lnRxSkip = true;
 
     // declaration and initialisation of the RX and TX queue
     // essentially the queue is just a pointer to the instance of the struct
-    initQueue(&lnTxQueue);
-    initQueue(&lnTxTempQueue);
-    initQueue(&lnRxQueue);
-    initQueue(&lnRxTempQueue);
-    initQueue(&lnTxCompQueue);
+    for (uint8_t i = 0; i < LN_TX_PRIORITIES; i++)
+    {
+        initQueue(&lnTxQueue[i], lnTxQueueValues[i], LN_TX_QUEUE_SIZE);
+        lnTxRetries[i] = 0;
+    }
+    lnTxPriority = LN_TX_PRIO_HIGH;
+    lnClearStats();
+    lnTxLength = 0;
+    lnTxSendCursor = 0;
+    lnTxEchoCursor = 0;
+    lnRxRing.head = 0;
+    lnRxRing.tail = 0;
+    lnRxRing.slots[0].length = 0;
+#ifdef LN_TRACE
+    lnTraceInit();
+#endif
 
     // init of the other elements (clock, comparator, EUSART, timer, ISR, leds)
     lnInitCmp1();
@@ -38,8 +73,9 @@ void lnInit(lnRxMsgCallback_t fptr)
     lnInitIsr();
     lnInitLeds();
 
-    // set LN at startup in IDLE mode
-    startIdleDelay();
+    // LN must be free during the CMP delay before the first transmit, after
+    // the CMP delay the LN driver is in IDLE mode
+    startCmpDelay();
 }
 
 /**
@@ -158,16 +194,16 @@ void lnIsrTmr1(void)
             if (isLnFree())
             {
                 // LN is free
-                if (!isQueueEmpty(&lnTxQueue))
+                if (getLnTxPriority() < LN_TX_PRIORITIES)
                 {
-                    // if LN TX queue has a LN message 
+                    // if a LN TX queue has a LN message 
                     startLnTxMessage();
                 }
                 else
                 {
                     // LN is free but has nothing to transmit
-                    // restart timer 1 with idle delay
-                    startIdleDelay();
+                    // stop timer 1 till a LN message is added
+                    startIdleMode();
                 }
             }
             else
@@ -180,8 +216,8 @@ void lnIsrTmr1(void)
             // after the CMP delay
             if (isLnFree())
             {
-                // if LN line is free start timer 1 with idle delay
-                startIdleDelay();
+                // if LN line is free the LN driver is in IDLE mode
+                startIdleMode();
             }
             else
             {
@@ -202,18 +238,30 @@ void lnIsrTmr1(void)
 }
 
 /**
- * start of the idle delay (1000s)
+ * start of the idle mode
+ * timer 1 only runs if a LN message waits in the LN TX queue, then the
+ * transmit starts after the kick delay (1s), otherwise timer 1 is stopped
+ * (no periodic interrupt) and the LN TX handler restarts it (see lnTxKick)
+ * in IDLE mode the CMP delay is over and LN is free since then (every
+ * received byte restarts the CMP delay), so the transmit may start at once
  */
-void startIdleDelay(void)
+void startIdleMode(void)
 {
-    // delay = 1000s (timer 1 in idle mode)
-    TMR1H = (uint8_t) (~TIMER1_IDLE >> 8); // set delay in timer 1
-    TMR1L = (uint8_t) (~TIMER1_IDLE & 0x00ff);
-    // WRITETIMER1(~TIMER1_IDLE); // set delay in timer 1
-    // disable TX and enable timer interrupts
+    // disable TX interrupt
     PIE3bits.TX1IE = false; // disable EUSART 1 TXD interrupt
-    PIE4bits.TMR1IE = true; // enable timer 1 overflow interrupt
-    T1CONbits.TMR1ON = true; // enable timer 1
+    if (getLnTxPriority() < LN_TX_PRIORITIES)
+    {
+        // delay = 1s (timer 1 in idle mode)
+        TMR1H = (uint8_t) (~TIMER1_KICK >> 8); // set delay in timer 1
+        TMR1L = (uint8_t) (~TIMER1_KICK & 0x00ff);
+        PIE4bits.TMR1IE = true; // enable timer 1 overflow interrupt
+        T1CONbits.TMR1ON = true; // enable timer 1
+    }
+    else
+    {
+        PIE4bits.TMR1IE = false; // disable timer 1 overflow interrupt
+        T1CONbits.TMR1ON = false; // disable timer 1
+    }
     // set device in IDLE mode
     LNCON.LN_MODE = IDLE;
     // in idle mode, the leds on LN (RX + TX) can be turned off (active high)
@@ -228,7 +276,27 @@ void startCmpDelay(void)
     // delay CMP = 1200s + 360s + random (between 0s and 1023s)
     uint16_t delay = getRandomValue(lastRandomValue);
     lastRandomValue = delay; // store last value of random generator
-    delay &= 2047U; // get random value between 0 and 1023
+    // the priority delay depends on the class of the next LN message
+    // high priority: random value between 0s and 511s
+    // low priority (or nothing to transmit): between 512s and 1023s
+    // after every collision of the LN message the window is doubled
+    // (max. LN_TX_BACKOFF_MAX times)
+    uint8_t priority = getLnTxPriority();
+    uint16_t window = 1024U;
+    if (priority < LN_TX_PRIORITIES)
+    {
+        uint8_t retries = lnTxRetries[priority];
+        if (retries > LN_TX_BACKOFF_MAX)
+        {
+            retries = LN_TX_BACKOFF_MAX;
+        }
+        window <<= retries;
+    }
+    delay &= (window - 1);
+    if (priority != LN_TX_PRIO_HIGH)
+    {
+        delay += window;
+    }
     delay += 3120U; // add C + M delay (= 1560s)
     TMR1H = (uint8_t) (~delay >> 8); // set delay in timer 1
     TMR1L = (uint8_t) (~delay & 0x00ff);
@@ -250,6 +318,13 @@ void startCmpDelay(void)
  */
 void startLinebreak(uint16_t timeLinebreak)
 {
+    LN_TRACE_ADD(LN_TRACE_LINEBREAK, (uint8_t) (timeLinebreak >> 4));
+    // a linebreak in TX mode means that the LN message is not transmitted
+    if (LNCON.LN_MODE == TX)
+    {
+        lnTxCollision();
+    }
+    lnStats.linebreaks++;
     // linebreak detect by framing error
     disableEusartPort();
     // a LN linebreak definition 
@@ -265,36 +340,43 @@ void startLinebreak(uint16_t timeLinebreak)
 }
 
 /**
- * random generator with Galois shift register
- * @param lfsr: initial value for the shift register
- * @return a 16 bit random vaule
+ * seed the random generator of the priority delay with a value that is
+ * unique per board, so boards that are powered up together don't draw the
+ * same delays (and collide in lockstep)
+ * @param seed: the unique value of the board (the DIP switch address)
+ */
+void lnSeedRandom(uint8_t seed)
+{
+    // spread the seeds over the LFSR sequence (multiply with an odd constant)
+    lastRandomValue = 0xace1 ^ (uint16_t) (seed * 0x9e37U);
+}
+
+/**
+ * random generator with a xorshift register (1 step per call)
+ * @param startState: the previous value of the generator
+ * @return a 16 bit random value
  */
 uint16_t getRandomValue(uint16_t startState)
 {
-    // with the help of a Galois LFSR (linear-feedback shift register)
-    // we can get a random number. The LFSR is a shift register whose
-    // input bit is a linear function of its previous state
-    // refer: https://en.wikipedia.org/wiki/Linear-feedback_shift_register
+    // a xorshift register (shifts of 7, 9 and 8 bits) is a linear-feedback
+    // shift register that shifts many bits in 1 step, so every value has 16
+    // new bits (after 1 shift of a Galois LFSR the value is the previous
+    // value shifted, so boards that draw close values keep drawing close
+    // values and collide again), the period is 65535 values
+    // the shift of 8 bits is a byte move, so 1 step costs a few instructions
+    // (startCmpDelay draws a value after every received LN byte)
+    // refer: https://en.wikipedia.org/wiki/Xorshift
 
     if (startState == 0)
     {
         startState = 0xace1; // start state
     }
 
-    uint16_t lfsr = startState;
-    do
-    {
-        uint16_t lsb = lfsr & 1u; // get LSB (i.e. the output bit)
-
-        lfsr >>= 1; // shift register to right
-        if (lsb) // if the output bit is 1
-        {
-            lfsr ^= 0xb400u; // apply toggle mask
-        }
-    }
-    while (lfsr == startState);
-
-    return lfsr;
+    uint16_t value = startState;
+    value ^= value << 7;
+    value ^= value >> 9;
+    value ^= value << 8;
+    return value;
 }
 
 // </editor-fold>
@@ -307,19 +389,24 @@ uint16_t getRandomValue(uint16_t startState)
  */
 void lnIsrRc(uint8_t lnRxData)
 {
+    LN_TRACE_ADD(LN_TRACE_RX, lnRxData);
     if (LNCON.LN_MODE == TX)
     {
         // device is in TX mode
-        // check if received byte = last transmitted byte
-        if (lnRxData == lnTxCompQueue.values[lnTxCompQueue.head])
+        // check if received byte = transmitted byte at the echo cursor
+        // (the record starts with the length of the LN message)
+        lnQueue_t* lnQueue = &lnTxQueue[lnTxPriority];
+        if ((lnTxEchoCursor < lnTxSendCursor) &&
+                (lnRxData == peekQueue(lnQueue, lnTxEchoCursor + 1)))
         {
-            deQueue(&lnTxCompQueue);
-            if (isQueueEmpty(&lnTxCompQueue))
+            lnTxEchoCursor++;
+            if (lnTxEchoCursor == lnTxLength)
             {
                 // now we are sure that the LN message is well transmitted
                 // at this point we could remove the last transmitted LN
                 // message from the TX queue
-                removeLastLnMessageFromQueue(&lnTxQueue);
+                removeLastLnMessageFromQueue(lnQueue);
+                lnTxRetries[lnTxPriority] = 0;
                 // restart CMP delay
                 startCmpDelay();
             }
@@ -347,42 +434,130 @@ void lnIsrRc(uint8_t lnRxData)
  */
 void rxHandler(uint8_t lnRxData)
 {
+    // the incoming bytes are written in the slot at the tail of the ring
+    lnRxSlot_t* slot = &lnRxRing.slots[lnRxRing.tail & (LN_RX_SLOTS - 1)];
+
     // start testing if msb = 1 (this is the startbyte of the LN message)
     if ((lnRxData & 0x80) == 0x80)
     {
-        clearQueue(&lnRxTempQueue);
-        enQueue(&lnRxTempQueue, lnRxData);
+        // the bytes of an incomplete LN message are lost
+        lnStats.rxDroppedBytes += slot->length;
+        slot->length = 0;
+        // only the LN messages of the opcode table are received, the bytes
+        // of the other LN messages are skipped till the next startbyte
+        slot->entry = getLnRxOpcodeEntry(lnRxData);
+        lnRxSkip = (slot->entry == LN_RX_SKIP);
+        if (!lnRxSkip)
+        {
+            slot->values[0] = lnRxData;
+            slot->length = 1;
+            // the length and the checksum are tracked while the bytes
+            // arrive, so the end of the LN message is tested at once
+            lnRxLength = lnRxOpcodes[slot->entry].length;
+            lnRxChecksum = lnRxData;
+        }
     }
-    else
+    else if (lnRxSkip)
     {
-        enQueue(&lnRxTempQueue, lnRxData);
-
-        // determine length of LN message
-        uint8_t lnMessageLength;
-        lnMessageLength = (lnRxTempQueue.values[lnRxTempQueue.head] & 0x60);
-        lnMessageLength = (lnMessageLength >> 4) + 2;
-        if (lnMessageLength > 6)
+        // byte of a skipped LN message
+    }
+    else if ((slot->length > 0) && (slot->length < LN_RX_SLOT_SIZE))
+    {
+        slot->values[slot->length] = lnRxData;
+        slot->length++;
+        lnRxChecksum ^= lnRxData;
+
+        // the 2nd byte of a variable LN message (opcode 0xe0 - 0xff) is the
+        // length of the LN message
+        if ((slot->length == 2) && ((slot->values[0] & 0x60) == 0x60) &&
+                (lnRxData != lnRxLength))
         {
-            lnMessageLength = lnRxTempQueue.values[(lnRxTempQueue.head + 1) % lnRxTempQueue.size];
+            // length not expected, skip the LN message
+            lnStats.rxDroppedBytes += slot->length;
+            slot->length = 0;
+            lnRxSkip = true;
         }
-
         // has LN message reached the end the test checksum
-        if (lnMessageLength == lnRxTempQueue.numEntries)
+        else if (lnRxLength == slot->length)
         {
-            if (isChecksumCorrect(&lnRxTempQueue))
+            // the next slot must be free to complete the LN message
+            bool isRingFull = ((uint8_t) (lnRxRing.tail + 1 - lnRxRing.head)
+                    >= LN_RX_SLOTS);
+            // the XOR of all bytes (checksum included) must be 0xff
+            if ((lnRxChecksum == 0xff) && !isRingFull)
+            {
+                // the slot holds a complete LN message, the next bytes
+                // are written in the next slot of the ring
+                lnRxRing.slots[(lnRxRing.tail + 1) & (LN_RX_SLOTS - 1)].length
+                        = 0;
+                lnRxRing.tail++;
+                uint8_t numEntries = (uint8_t) (lnRxRing.tail - lnRxRing.head);
+                if (numEntries > lnStats.rxHighWater)
+                {
+                    lnStats.rxHighWater = numEntries;
+                }
+#if LN_RX_DISPATCH == LN_RX_IN_ISR
+                // handle LN RX message (in the handler of the opcode table)
+                // and release the slot
+                (*lnRxOpcodes[slot->entry].handler)(slot->values,
+                        slot->length);
+                lnRxRing.head++;
+#endif
+            }
+            else
             {
-                // if checksum is correct then copy LN RX temp queue to
-                // LN RX queue
-                while (!isQueueEmpty(&lnRxTempQueue))
+                // wrong LN message (or no free slot), ignore the bytes till
+                // the next startbyte
+                if (!isRingFull)
                 {
-                    enQueue(&lnRxQueue, lnRxTempQueue.values[lnRxTempQueue.head]);
-                    deQueue(&lnRxTempQueue);
+                    lnStats.checksumErrors++;
                 }
-                // handle LN RX message (in the callback function)
-                (*lnRxMsgCallback)(&lnRxQueue);
+                lnStats.rxDroppedBytes += slot->length;
+                slot->length = 0;
             }
         }
     }
+    else
+    {
+        // byte outside a LN message (or LN message too long)
+        lnStats.rxDroppedBytes++;
+    }
+}
+
+/**
+ * get the entry of the opcode table for an opcode
+ * @param opcode: the opcode (startbyte of the LN message)
+ * @return the index of the opcode table (LN_RX_SKIP: not in the table)
+ */
+uint8_t getLnRxOpcodeEntry(uint8_t opcode)
+{
+    for (uint8_t i = 0; i < lnRxOpcodesSize; i++)
+    {
+        if (lnRxOpcodes[i].opcode == opcode)
+        {
+            return i;
+        }
+    }
+    return LN_RX_SKIP;
+}
+
+/**
+ * LN RX ring handler (main loop), handles the complete LN messages in the
+ * LN RX ring (in the handler of the opcode table) and releases their slots
+ * (LN_RX_IN_MAIN, with LN_RX_IN_ISR the LN messages are handled in isrLow)
+ */
+void lnRxRingHandler(void)
+{
+#if LN_RX_DISPATCH == LN_RX_IN_MAIN
+    // isrLow only writes the tail and a slot that is not complete, so the
+    // complete LN messages can be read without disabling the interrupts
+    while (lnRxRing.head != lnRxRing.tail)
+    {
+        lnRxSlot_t* slot = &lnRxRing.slots[lnRxRing.head & (LN_RX_SLOTS - 1)];
+        (*lnRxOpcodes[slot->entry].handler)(slot->values, slot->length);
+        lnRxRing.head++;
+    }
+#endif
 }
 
 // </editor-fold>
@@ -394,8 +569,8 @@ void rxHandler(uint8_t lnRxData)
  */
 void lnIsrTx(void)
 {
-    // send ln data as long queue is not empty
-    if (!isQueueEmpty(&lnTxTempQueue))
+    // send ln data as long as the send cursor is in the LN message
+    if (lnTxSendCursor < lnTxLength)
     {
         sendTxByte();
     }
@@ -403,21 +578,152 @@ void lnIsrTx(void)
 
 /**
  * start routine for transmitting a LN message
- * @param lnTxMsg: the message to transmit
+ * @param lnTxMsg: the LN message to transmit (with checksum)
+ * @param length: the length of the LN message
+ * @param priority: the priority class of the message (LN_TX_PRIO_HIGH or
+ * LN_TX_PRIO_LOW)
+ * @return LN_TX_OK: the LN message is added to the LN TX queue,
+ * LN_TX_FULL: the LN TX queue has no space for the LN message (try later),
+ * LN_TX_INVALID: the LN message is empty or too long (LN_TX_MSG_SIZE)
+ */
+lnTxStatus_t lnTxMessageHandler(uint8_t* lnTxMsg, uint8_t length,
+        lnTxPriority_t priority)
+{
+    lnTxStatus_t status;
+
+    if ((length < 2) || (length > LN_TX_MSG_SIZE) ||
+            (priority >= LN_TX_PRIORITIES))
+    {
+        status = LN_TX_INVALID;
+        lnStats.txRejected++;
+    }
+    else if ((length + 1) > getQueueFree(&lnTxQueue[priority]))
+    {
+        // the LN message is only added if the complete record fits
+        status = LN_TX_FULL;
+        lnStats.txRejected++;
+    }
+    else
+    {
+        // write the LN message into the LN TX queue as 1 record
+        // (length + LN message with checksum)
+        enQueue(&lnTxQueue[priority], length);
+        enQueueSpan(&lnTxQueue[priority], lnTxMsg, length);
+        if (lnTxQueue[priority].numEntries > lnStats.txHighWater[priority])
+        {
+            lnStats.txHighWater[priority] = lnTxQueue[priority].numEntries;
+        }
+        status = LN_TX_OK;
+        lnTxKick();
+    }
+    return status;
+}
+
+/**
+ * start the transmit of a LN message that is added to the LN TX queue in
+ * IDLE mode (timer 1 is stopped when the LN TX queue is empty)
+ * in the other modes the LN message is transmitted after the current
+ * transmit or CMP delay
+ */
+void lnTxKick(void)
+{
+    // called with the low priority interrupts disabled (LN_TX_LOCK)
+    if ((LNCON.LN_MODE == IDLE) && !T1CONbits.TMR1ON)
+    {
+        startIdleMode();
+    }
+}
+
+/**
+ * start routine for transmitting a LN status report (latest state wins)
+ * if a report with the same opcode and address is still waiting in one of
+ * the LN TX queues, this report is overwritten with the new state (so there
+ * is max. 1 report per object in the queues), otherwise the report is added
+ * both queues are searched: after LN_TX_MAX_RETRIES collisions a report of
+ * the high priority class is moved to the low priority queue
+ * (LN_TX_DEPRIORITISE), the overwritten report keeps its place
+ * @param lnTxMsg: the report to transmit (with checksum)
+ * @param length: the length of the report
+ * @param priority: the priority class of the report
+ * @return the status (see lnTxMessageHandler)
+ */
+lnTxStatus_t lnTxReportHandler(uint8_t* lnTxMsg, uint8_t length,
+        lnTxPriority_t priority)
+{
+    if ((length < 3) || (length > LN_TX_MSG_SIZE) ||
+            (priority >= LN_TX_PRIORITIES))
+    {
+        return LN_TX_INVALID;
+    }
+    for (uint8_t i = 0; i < LN_TX_PRIORITIES; i++)
+    {
+        if (updateLnReport((lnTxPriority_t) i, lnTxMsg, length))
+        {
+            return LN_TX_OK;
+        }
+    }
+    // no pending report for this object, add it to the queue
+    return lnTxMessageHandler(lnTxMsg, length, priority);
+}
+
+/**
+ * overwrite a waiting report with the same opcode and address (the key) in
+ * a LN TX queue with the new state
+ * @param priority: the priority class of the LN TX queue
+ * @param lnTxMsg: the report (with checksum)
+ * @param length: the length of the report
+ * @return true: if a report is overwritten
  */
-void lnTxMessageHandler(lnQueue_t* lnTxMsg)
+bool updateLnReport(lnTxPriority_t priority, uint8_t* lnTxMsg, uint8_t length)
 {
-    // copy the LN message into the LN TX queue
-    // and add the calculated checksum
-    uint8_t checksum = 0x00;
+    lnQueue_t* lnQueue = &lnTxQueue[priority];
+    uint8_t mask = getLnAddressMask(lnTxMsg[0]);
+    uint8_t offset = 0;
+    // the record at the head is in transmission (TX mode), don't touch it
+    if ((LNCON.LN_MODE == TX) && (lnTxPriority == priority) &&
+            !isQueueEmpty(lnQueue))
+    {
+        offset = peekQueue(lnQueue, 0) + 1;
+    }
+    // search a record with the same opcode and address (the key)
+    while (offset < lnQueue->numEntries)
+    {
+        uint8_t recordLength = peekQueue(lnQueue, offset);
+        if ((recordLength == length) &&
+                (peekQueue(lnQueue, offset + 1) == lnTxMsg[0]) &&
+                (peekQueue(lnQueue, offset + 2) == lnTxMsg[1]) &&
+                ((peekQueue(lnQueue, offset + 3) & mask) ==
+                (lnTxMsg[2] & mask)))
+        {
+            // overwrite the report in place
+            for (uint8_t i = 0; i < length; i++)
+            {
+                pokeQueue(lnQueue, offset + 1 + i, lnTxMsg[i]);
+            }
+            return true;
+        }
+        offset += recordLength + 1;
+    }
+    return false;
+}
 
-    while (!isQueueEmpty(lnTxMsg))
+/**
+ * get the address bits of the 2nd data byte of a LN report
+ * (the 1st data byte holds always address bits A0 - A6)
+ * @param opcode: the opcode of the LN report
+ * @return the mask of the address bits
+ */
+uint8_t getLnAddressMask(uint8_t opcode)
+{
+    switch (opcode)
     {
-        checksum ^= lnTxMsg->values[lnTxMsg->head];
-        enQueue(&lnTxQueue, lnTxMsg->values[lnTxMsg->head]);
-        deQueue(lnTxMsg);
+        case 0xb2:
+            // OPC_INPUT_REP: 0, X, I, L, A10, A9, A8, A7 (I = address bit)
+            return 0x2f;
+        default:
+            // OPC_SW_REP, OPC_SW_REQ: 0, 0, C/DIR, T/ON, A10, A9, A8, A7
+            return 0x0f;
     }
-    enQueue(&lnTxQueue, (checksum ^ 0xff));
 }
 
 /**
@@ -428,23 +734,21 @@ void startLnTxMessage(void)
     // this routine is driven by (timer) interrupt, so don't call it directly !
     // set the device in TX mode
     setTxMode();
-    // clear temporary & comparator queue
-    clearQueue(&lnTxTempQueue);
-    clearQueue(&lnTxCompQueue);
-    // copy the LN message from LN TX queue into the LN TX temporary queue
-    // get bytes till queue is empty or next byte starts with 0x80 (msb = 1)
-    uint8_t pointer = lnTxQueue.head;
-    do
-    {
-        enQueue(&lnTxTempQueue, lnTxQueue.values[pointer]);
-        pointer = (pointer + 1) % lnTxQueue.size;
-    }
-    while ((pointer != lnTxQueue.tail) &&
-            ((lnTxQueue.values[pointer] & 0x80) != 0x80));
+    // take the LN message of the highest priority class
+    // the LN message is transmitted from its record in the LN TX queue (no
+    // copy), the record stays at the head of the queue till the complete
+    // echo (see lnIsrRc), after a collision it is transmitted again from
+    // the start (see lnTxCollision)
+    lnTxPriority = getLnTxPriority();
+    // the record in the LN TX queue starts with the length of the LN message
+    lnTxLength = peekQueue(&lnTxQueue[lnTxPriority], 0);
+    lnTxSendCursor = 0;
+    lnTxEchoCursor = 0;
     // last check is LN bus is free
     if (isLnFree())
     {
         // if free, start sending the first byte
+        lnStats.attempts++;
         sendTxByte();        
      }
     else
@@ -459,14 +763,66 @@ void startLnTxMessage(void)
  */
 void sendTxByte(void)
 {
-    // transmit the byte
-    TX1REG = lnTxTempQueue.values[lnTxTempQueue.head];
-    // the last transmitted byte must be stored in the comparator queue
-    // this is necessary to check if the data is transmitted correctly
-    // (see routine lnIsrRc)
-    enQueue(&lnTxCompQueue, lnTxTempQueue.values[lnTxTempQueue.head]);
-    // dequeue TX queue
-    deQueue(&lnTxTempQueue);
+    // transmit the byte at the send cursor
+    uint8_t lnTxData = peekQueue(&lnTxQueue[lnTxPriority], lnTxSendCursor + 1);
+    TX1REG = lnTxData;
+    LN_TRACE_ADD(LN_TRACE_TX, lnTxData);
+    // the byte stays in the record, its echo is compared at the echo cursor
+    // to check if the data is transmitted correctly (see routine lnIsrRc)
+    lnTxSendCursor++;
+}
+
+/**
+ * get the priority class of the next LN message to transmit
+ * @return the highest priority class with a LN message, LN_TX_PRIORITIES if
+ * all LN TX queues are empty
+ */
+uint8_t getLnTxPriority(void)
+{
+    uint8_t priority = 0;
+    while ((priority < LN_TX_PRIORITIES) && isQueueEmpty(&lnTxQueue[priority]))
+    {
+        priority++;
+    }
+    return priority;
+}
+
+/**
+ * handle a collision of the LN message in transmission
+ * after LN_TX_MAX_RETRIES collisions the retry policy is applied:
+ * LN_TX_DROP: the LN message is removed
+ * LN_TX_DEPRIORITISE: the LN message is moved to the end of the low priority
+ * queue (so the other LN messages are transmitted first)
+ */
+void lnTxCollision(void)
+{
+    lnStats.collisions++;
+    lnTxRetries[lnTxPriority]++;
+    if (lnTxRetries[lnTxPriority] < LN_TX_MAX_RETRIES)
+    {
+        return;
+    }
+    lnTxRetries[lnTxPriority] = 0;
+
+    lnQueue_t* lnQueue = &lnTxQueue[lnTxPriority];
+#if LN_TX_RETRY_POLICY == LN_TX_DEPRIORITISE
+    lnQueue_t* lnLowQueue = &lnTxQueue[LN_TX_PRIO_LOW];
+    uint8_t length = peekQueue(lnQueue, 0) + 1;
+    if (length <= getQueueFree(lnLowQueue))
+    {
+        // copy the record (length + LN message) to the low priority queue
+        for (uint8_t i = 0; i < length; i++)
+        {
+            enQueue(lnLowQueue, peekQueue(lnQueue, i));
+        }
+        deQueueSpan(lnQueue, length);
+        lnStats.deprioritised++;
+        return;
+    }
+#endif
+    // drop the LN message
+    removeLastLnMessageFromQueue(lnQueue);
+    lnStats.drops++;
 }
 
 /**
@@ -522,34 +878,52 @@ void disableEusartPort(void)
 
 /**
  * calculate the checksum
- * @param lnQueue: name of the queue (pass the address of the queue)
+ * @param lnMsg: the LN message
+ * @param length: the length of the LN message
  * @return true: if checksum is correct 
  */
-bool isChecksumCorrect(lnQueue_t* lnQueue)
+bool isChecksumCorrect(uint8_t* lnMsg, uint8_t length)
 {
     uint8_t checksum = 0;
-    for (uint8_t i = 0; i < lnQueue->numEntries; i++)
+    for (uint8_t i = 0; i < length; i++)
     {
-        checksum ^= lnQueue->values[(lnQueue->head + i) % lnQueue->size];
+        checksum ^= lnMsg[i];
     }
     return (checksum == 0xff);
 }
 
+/**
+ * clear the LN statistics (bus health)
+ */
+void lnClearStats(void)
+{
+    lnStats.attempts = 0;
+    lnStats.collisions = 0;
+    lnStats.drops = 0;
+    lnStats.deprioritised = 0;
+    lnStats.txRejected = 0;
+    lnStats.framingErrors = 0;
+    lnStats.overruns = 0;
+    lnStats.checksumErrors = 0;
+    lnStats.linebreaks = 0;
+    lnStats.rxDroppedBytes = 0;
+    for (uint8_t i = 0; i < LN_TX_PRIORITIES; i++)
+    {
+        lnStats.txHighWater[i] = 0;
+    }
+    lnStats.rxHighWater = 0;
+}
+
 /**
  * remove the last LN message from the queue
  * @param lnQueue: the queue where the LN message has to be removed
  */
 void removeLastLnMessageFromQueue(lnQueue_t* lnQueue)
 {
-    // remove bytes till queue is empty or next bytes starts with 0x80 (msb = 1)
+    // remove the complete record (length + LN message)
     if (!isQueueEmpty(lnQueue))
     {
-        do
-        {
-            deQueue(lnQueue);
-        }
-        while (!isQueueEmpty(lnQueue) &&
-                ((lnQueue->values[lnQueue->head] & 0x80) != 0x80));
+        deQueueSpan(lnQueue, peekQueue(lnQueue, 0) + 1);
     }
 }
 
@@ -8,6 +8,25 @@
  *  v1.0 Merge PIC18F2525/2620/4525/4620 and PIC18F24/25/26/27/45/46/47Q10 microcontrollers (20/07/2024)
  *  v1.1 Remove PIC18F2525/2620/4525/4620 (obsolete processor)
  *  v2.0 complete rework of LocoNet driver after some major bugs
+ *  v2.1 received LN messages are stored in a message slot ring (16/10/2026)
+ *  v2.2 capacity per TX queue (16/10/2026)
+ *  v2.3 LN messages are moved as a block (enQueueSpan, deQueueSpan), the
+ *       copy with getQueueSpan is withdrawn in v2.16 (16/10/2026)
+ *  v2.4 framed LN TX queue (length + LN message) (16/10/2026)
+ *  v2.5 LN TX priority classes (16/10/2026)
+ *  v2.6 latest state wins for the LN status reports (16/10/2026)
+ *  v2.7 bounded retries, backoff and TX statistics (16/10/2026)
+ *  v2.8 seed of the random generator per board (16/10/2026)
+ *  v2.9 LN bus health statistics (16/10/2026)
+ *  v2.10 received LN messages are handled in the main loop (16/10/2026)
+ *  v2.11 opcode table, the other LN messages are skipped (16/10/2026)
+ *  v2.12 running checksum of the received LN message (16/10/2026)
+ *  v2.13 the LN TX handlers copy a complete LN message (built by the caller,
+ *        e.g. from a report template) into the LN TX queue (16/10/2026)
+ *  v2.14 transmit started by the LN TX handler, no idle polling (16/10/2026)
+ *  v2.15 optional trace of the LN bytes (16/10/2026)
+ *  v2.16 transmit from the LN TX queue with send + echo cursor (16/10/2026)
+ *  v2.17 latest state wins over both priority classes (16/10/2026)
  */
 
 // this is a guard condition so that contents of this file are not included
@@ -16,11 +35,69 @@
 #define	LN_H
 
 #include "circular_queue.h"
+#include "trace.h"
 
 // definitions
 #define LINEBREAK_LONG 2500U
 #define LINEBREAK_SHORT 600U
-#define TIMER1_IDLE 2000U
+// delay of timer 1 to start the transmit of a LN message that is added to the
+// LN TX queue in IDLE mode (1us, the CMP delay is already over)
+#define TIMER1_KICK 2U
+// the received LN messages are handled (callback) in isrLow as soon as they
+// are complete (LN_RX_IN_ISR) or in the main loop by lnRxRingHandler
+// (LN_RX_IN_MAIN), then isrLow only frames and checks the LN messages
+#define LN_RX_IN_ISR 0
+#define LN_RX_IN_MAIN 1
+#ifndef LN_RX_DISPATCH
+#define LN_RX_DISPATCH LN_RX_IN_MAIN
+#endif
+// the received LN messages are written (once) in a ring of message slots
+// a slot must hold the longest LN message of the opcode table (the other LN
+// messages are skipped), the number of slots must be a power of 2 (1 slot
+// receives the incoming bytes, the others hold the complete LN messages till
+// the main loop has handled them)
+#if LN_RX_DISPATCH == LN_RX_IN_MAIN
+#define LN_RX_SLOTS 4U
+#else
+#define LN_RX_SLOTS 2U
+#endif
+#define LN_RX_SLOT_SIZE 16U
+// index of the opcode table for the LN messages that are skipped
+#define LN_RX_SKIP 0xffU
+// critical section around the LN TX queues and the LN message that is built
+// for them, isrLow transmits from the LN TX queues and can interrupt the main
+// loop (GIEL is restored, so it can be used in isrLow too)
+#define LN_TX_LOCK(var) bool var = INTCONbits.GIEL; INTCONbits.GIEL = false
+#define LN_TX_UNLOCK(var) INTCONbits.GIEL = var
+// capacity of the TX queues (power of 2)
+// LN TX queue: the LN messages waiting to be transmitted (1 queue per
+// priority class), every LN message is stored as a record (length + LN
+// message with checksum)
+// the LN message in transmission is transmitted from its record (send
+// cursor) and its echo is compared with the same bytes (echo cursor), the
+// record is removed after the complete echo
+#define LN_TX_QUEUE_SIZE 64U
+// longest LN message that the device transmits (with checksum)
+#define LN_TX_MSG_SIZE 16U
+
+// retry policy of a LN message after LN_TX_MAX_RETRIES collisions
+// (LN_TX_DROP: remove it, LN_TX_DEPRIORITISE: put it at the end of the low
+// priority queue), after every collision the random priority window is
+// doubled (max. 2 ^ LN_TX_BACKOFF_MAX times)
+#define LN_TX_DROP 0
+#define LN_TX_DEPRIORITISE 1
+#ifndef LN_TX_RETRY_POLICY
+#define LN_TX_RETRY_POLICY LN_TX_DEPRIORITISE
+#endif
+#define LN_TX_MAX_RETRIES 16U
+#define LN_TX_BACKOFF_MAX 3U
+
+#if !IS_QUEUE_SIZE_VALID(LN_TX_QUEUE_SIZE)
+#error "the capacity of a LN TX queue must be a power of 2 (max. QUEUE_SIZE)"
+#endif
+#if (LN_RX_SLOTS & (LN_RX_SLOTS - 1)) != 0
+#error "the number of LN RX message slots must be a power of 2"
+#endif
 
 typedef enum {
     IDLE,
@@ -29,6 +106,39 @@ typedef enum {
     TX
 } lnMode;
 
+// LN TX status (result of lnTxMessageHandler)
+
+typedef enum {
+    LN_TX_OK,
+    LN_TX_FULL,
+    LN_TX_INVALID
+} lnTxStatus_t;
+
+// LN TX priority class (the high priority queue is always drained first)
+
+typedef enum {
+    LN_TX_PRIO_HIGH,
+    LN_TX_PRIO_LOW,
+    LN_TX_PRIORITIES
+} lnTxPriority_t;
+
+// LN statistics (bus health)
+
+typedef struct {
+    uint16_t attempts; // number of LN messages started on the line
+    uint16_t collisions; // number of LN messages that are not well transmitted
+    uint16_t drops; // number of LN messages removed after too many retries
+    uint16_t deprioritised; // number of LN messages moved to low priority
+    uint16_t txRejected; // number of LN messages refused by the LN TX queue
+    uint16_t framingErrors; // number of EUSART framing errors
+    uint16_t overruns; // number of EUSART RX overruns
+    uint16_t checksumErrors; // number of received LN messages with bad checksum
+    uint16_t linebreaks; // number of linebreaks sent by the device
+    uint16_t rxDroppedBytes; // number of received bytes that are ignored
+    uint8_t txHighWater[LN_TX_PRIORITIES]; // max. bytes in the LN TX queues
+    uint8_t rxHighWater; // max. LN messages in the LN RX ring
+} lnStats_t;
+
 // LN flag register
 
 typedef struct {
@@ -36,11 +146,40 @@ typedef struct {
 } LNCON_t;
 LNCON_t LNCON;
 
+// LN RX message slot (1 received LN message)
+
+typedef struct {
+    uint8_t length;
+    uint8_t entry; // index of the opcode table
+    uint8_t values[LN_RX_SLOT_SIZE];
+} lnRxSlot_t;
+
+// LN RX message slot ring
+// single producer (isrLow writes tail) and single consumer (the callback
+// caller writes head), head and tail are free running counters, so the
+// number of complete LN messages is tail - head
+
+typedef struct {
+    volatile uint8_t head; // first complete LN message (to be handled)
+    volatile uint8_t tail; // slot that receives the incoming bytes
+    lnRxSlot_t slots[LN_RX_SLOTS];
+} lnRxRing_t;
+
 // LN RX message callback definition (as function pointer)
-typedef void (*lnRxMsgCallback_t)(lnQueue_t*);
+// the LN message is passed as a view (pointer, length) on the slot
+typedef void (*lnRxMsgCallback_t)(uint8_t*, uint8_t);
+
+// LN RX opcode table entry, only the LN messages with an opcode of the table
+// are received (buffered, checksum tested and passed to their handler)
+
+typedef struct {
+    uint8_t opcode;
+    uint8_t length; // length of the LN message (the other lengths are skipped)
+    lnRxMsgCallback_t handler;
+} lnRxOpcode_t;
 
 // LN init routines
-void lnInit(lnRxMsgCallback_t);
+void lnInit(const lnRxOpcode_t*, uint8_t);
 void lnInitCmp1(void);
 void lnInitEusart1(void);
 void lnInitTmr1(void);
@@ -49,41 +188,59 @@ void lnInitLeds(void);
 
 // LN timer 1 routines
 void lnIsrTmr1(void);
-void startIdleDelay(void);
+void startIdleMode(void);
 void startCmpDelay(void);
 void startLinebreak(uint16_t);
+void lnSeedRandom(uint8_t);
 uint16_t getRandomValue(uint16_t);
 
 // LN RX routines
 void lnIsrRc(uint8_t);
 void rxHandler(uint8_t);
+uint8_t getLnRxOpcodeEntry(uint8_t);
+void lnRxRingHandler(void);
 
 // LN TX routines
 void lnIsrTx(void);
-void lnTxMessageHandler(lnQueue_t*);
+lnTxStatus_t lnTxMessageHandler(uint8_t*, uint8_t, lnTxPriority_t);
+lnTxStatus_t lnTxReportHandler(uint8_t*, uint8_t, lnTxPriority_t);
+bool updateLnReport(lnTxPriority_t, uint8_t*, uint8_t);
+void lnTxKick(void);
+uint8_t getLnAddressMask(uint8_t);
 void startLnTxMessage(void);
 void sendTxByte(void);
+uint8_t getLnTxPriority(void);
+void lnTxCollision(void);
 void setTxMode(void);
 
 // LN aux. routines
 bool isLnFree(void);
 void enableEusartPort(void);
 void disableEusartPort(void);
-bool isChecksumCorrect(lnQueue_t*);
+bool isChecksumCorrect(uint8_t*, uint8_t);
 void removeLastLnMessageFromQueue(lnQueue_t*);
+void lnClearStats(void);
 
 // LN mode (IDLE, CMP, Linebreak, TX, ...)
 
 // LN used variables
-lnRxMsgCallback_t lnRxMsgCallback;
+const lnRxOpcode_t* lnRxOpcodes; // opcode table
+uint8_t lnRxOpcodesSize; // number of entries of the opcode table
+bool lnRxSkip; // the LN message on the line is skipped
+uint8_t lnRxLength; // length of the LN message in the slot (opcode table)
+uint8_t lnRxChecksum; // running checksum (XOR) of the LN message in the slot
 uint16_t lastRandomValue; // initial value for the random generator
 uint8_t _; // dummy variable
 
-lnQueue_t lnTxQueue;
-lnQueue_t lnTxTempQueue;
-lnQueue_t lnTxCompQueue;
-lnQueue_t lnRxQueue;
-lnQueue_t lnRxTempQueue;
+lnQueue_t lnTxQueue[LN_TX_PRIORITIES];
+uint8_t lnTxQueueValues[LN_TX_PRIORITIES][LN_TX_QUEUE_SIZE];
+uint8_t lnTxPriority; // priority class of the LN message in transmission
+uint8_t lnTxRetries[LN_TX_PRIORITIES]; // collisions of the first LN message
+lnStats_t lnStats;
+uint8_t lnTxLength; // length of the LN message in transmission
+uint8_t lnTxSendCursor; // next byte of the LN message to transmit
+uint8_t lnTxEchoCursor; // next byte of the LN message to compare (echo)
+lnRxRing_t lnRxRing;
 
 #endif	/* LN_H */
 
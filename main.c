@@ -5,6 +5,9 @@
  *
  * revision history:
  *  v1.0 creation (16/08/2024)
+ *  v1.1 handle the received LN messages (16/10/2026)
+ *  v1.2 transmit the pending LN messages (16/10/2026)
+ *  v1.3 debounce the DIP switch address (16/10/2026)
  */
 
 #include "config.h"
@@ -22,6 +25,12 @@ void main(void)
     while (true)
     {
         updateLeds();
+        // handle the received LN messages (LN_RX_IN_MAIN)
+        lnRxRingHandler();
+        // retry the LN messages that didn't fit in the LN TX queue
+        lnTxPendingHandler();
+        // re-read the DIP switch address
+        dipSwitchHandler();
     }
     return;
 }
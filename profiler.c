@@ -0,0 +1,107 @@
+/*
+ * file: profiler.c
+ * author: J. van Hooydonk
+ * comments: ISR execution time profiler (optional)
+ *
+ * revision history:
+ *  v1.0 Creation (16/10/2026)
+ */
+
+#include "profiler.h"
+
+#ifdef ISR_PROFILE
+
+// upper limits of the histogram bins (in timer 5 ticks)
+const uint16_t profileBinLimits[PROFILE_BINS - 1] = {
+    25 * PROFILE_TICKS_PER_US,
+    50 * PROFILE_TICKS_PER_US,
+    100 * PROFILE_TICKS_PER_US,
+    200 * PROFILE_TICKS_PER_US,
+    400 * PROFILE_TICKS_PER_US
+};
+
+/**
+ * initialisation of the profiler and timer 5 (free-running)
+ */
+void profileInit(void)
+{
+    for (uint8_t i = 0; i < PROFILE_SOURCES; i++)
+    {
+        profileList[i].min = 0xffff;
+        profileList[i].max = 0;
+        profileList[i].sum = 0;
+        profileList[i].count = 0;
+        for (uint8_t j = 0; j < PROFILE_BINS; j++)
+        {
+            profileList[i].bins[j] = 0;
+        }
+    }
+    TMR5H = 0x00; // reset timer 5
+    TMR5L = 0x00;
+    TMR5CLK = 0x01; // clock source to Fosc / 4
+    T5CON = 0b00000010; // T5CKPS = 0b00 (1:1 prescaler), RD16 = 1 (16 bit)
+    T5CONbits.ON = true; // enable timer 5 (without interrupt)
+}
+
+/**
+ * get the time of the free-running timer 5
+ * @return the time (in ticks of 62.5ns)
+ */
+uint16_t profileGetTime(void)
+{
+    // reading TMR5L latches TMR5H (16 bit read mode)
+    uint8_t low = TMR5L;
+    return (uint16_t) ((TMR5H << 8) | low);
+}
+
+/**
+ * add an execution time to the profile of a source
+ * @param source: the source (see profileSource_t)
+ * @param time: the execution time (in ticks of 62.5ns)
+ */
+void profileAdd(uint8_t source, uint16_t time)
+{
+    profile_t* profile = &profileList[source];
+
+    if (time < profile->min)
+    {
+        profile->min = time;
+    }
+    if (time > profile->max)
+    {
+        profile->max = time;
+    }
+    // the average stays valid when the counter is at his end
+    if (profile->count < 0xffff)
+    {
+        profile->sum += time;
+        profile->count++;
+    }
+    uint8_t bin = 0;
+    while ((bin < (PROFILE_BINS - 1)) && (time >= profileBinLimits[bin]))
+    {
+        bin++;
+    }
+    if (profile->bins[bin] < 0xffff)
+    {
+        profile->bins[bin]++;
+    }
+}
+
+/**
+ * get the average execution time of a source
+ * @param source: the source (see profileSource_t)
+ * @return the average time (in ticks of 62.5ns)
+ */
+uint16_t profileGetAverage(uint8_t source)
+{
+    profile_t* profile = &profileList[source];
+
+    if (profile->count == 0)
+    {
+        return 0;
+    }
+    return (uint16_t) (profile->sum / profile->count);
+}
+
+#endif
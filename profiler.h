@@ -0,0 +1,73 @@
+/*
+ * file: profiler.h
+ * author: J. van Hooydonk
+ * comments: ISR execution time profiler (optional)
+ *
+ * the profiler measures the execution time of the interrupt routines with
+ * the free-running timer 5 (Fosc / 4, 1 tick = 62.5ns) and keeps per source
+ * the min/avg/max time and a histogram
+ * enable it with ISR_PROFILE (below or on the command line of the compiler),
+ * without ISR_PROFILE the PROFILE_BEGIN/PROFILE_END macros are empty
+ *
+ * revision history:
+ *  v1.0 Creation (16/10/2026)
+ */
+
+// This is a guard condition so that contents of this file are not included
+// more than once.
+#ifndef PROFILER_H
+#define	PROFILER_H
+
+#include "config.h"
+
+// #define ISR_PROFILE
+
+// definitions
+// number of histogram bins, the upper limits (in timer 5 ticks) are
+// 25s, 50s, 100s, 200s, 400s and more (the budget of isrLow is 600s)
+#define PROFILE_BINS 6
+#define PROFILE_TICKS_PER_US 16U
+
+// sources (interrupt routines and their branches)
+
+typedef enum {
+    PROFILE_ISR_HIGH,
+    PROFILE_ISR_LOW,
+    PROFILE_SERVO_CCP1,
+    PROFILE_LN_TMR1,
+    PROFILE_LN_TX,
+    PROFILE_LN_RC,
+    PROFILE_SERVO_TMR3,
+    PROFILE_S_TMR3,
+    PROFILE_SOURCES
+} profileSource_t;
+
+// profile of 1 source
+
+typedef struct {
+    uint16_t min; // shortest execution time (ticks)
+    uint16_t max; // longest execution time (ticks)
+    uint32_t sum; // sum of the execution times (ticks)
+    uint16_t count; // number of executions (stops at 0xffff)
+    uint16_t bins[PROFILE_BINS]; // histogram (stops at 0xffff per bin)
+} profile_t;
+
+#ifdef ISR_PROFILE
+// mark the begin (store timer 5 in a local variable) and the end of a routine
+#define PROFILE_BEGIN(var) uint16_t var = profileGetTime()
+#define PROFILE_END(source, var) profileAdd(source, profileGetTime() - var)
+
+// routines
+void profileInit(void);
+uint16_t profileGetTime(void);
+void profileAdd(uint8_t, uint16_t);
+uint16_t profileGetAverage(uint8_t);
+
+// variables
+profile_t profileList[PROFILE_SOURCES];
+#else
+#define PROFILE_BEGIN(var)
+#define PROFILE_END(source, var)
+#endif
+
+#endif	/* PROFILER_H */
@@ -6,6 +6,7 @@
  * revision history:
  *  v1.0 Creation (15/09/2024)
  *  v1.1 Keep state of S in EEPROM, other corrections (23/08/2025)
+ *  v1.2 the callback of KOS/KFS gets the index of the signal (16/10/2026)
  */
 
 #include "s.h"
@@ -301,7 +302,7 @@ void setKOS(uint8_t index, bool value)
         // change KOS status
         sList[index].KOS = value;
         // handle LN RX message (in the callback function)
-        (*sCallback)(0);
+        (*sCallback)(index);
     }
 }
 
@@ -317,7 +318,7 @@ void setKFS(uint8_t index, bool value)
         // change KFS status
         sList[index].KFS = value;
         // handle LN RX message (in the callback function)
-        (*sCallback)(0);
+        (*sCallback)(index);
     }
 }
 
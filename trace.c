@@ -0,0 +1,102 @@
+/*
+ * file: trace.c
+ * author: J. van Hooydonk
+ * comments: trace of the LN bytes (optional)
+ *
+ * revision history:
+ *  v1.0 Creation (16/10/2026)
+ *  v1.1 the trace is released when a dump is abandoned (16/10/2026)
+ */
+
+#include "trace.h"
+
+#ifdef LN_TRACE
+
+/**
+ * initialisation of the trace (all entries empty) and timer 0 (free-running)
+ */
+void lnTraceInit(void)
+{
+    for (uint8_t i = 0; i < LN_TRACE_SIZE; i++)
+    {
+        lnTraceBuffer[i].time = 0;
+        lnTraceBuffer[i].data = 0;
+        lnTraceBuffer[i].flags = LN_TRACE_EMPTY;
+    }
+    lnTraceHead = 0;
+    lnTraceFrozen = false;
+    lnTraceRelease = 0;
+    TMR0H = 0x00; // reset timer 0
+    TMR0L = 0x00;
+    T0CON1 = 0b01000110; // T0CS = 0b010 (Fosc / 4), T0CKPS = 0b0110 (1:64)
+    T0CON0 = 0b10010000; // T0EN = 1, T016BIT = 1 (16 bit, without interrupt)
+}
+
+/**
+ * add an entry to the trace (the oldest entry is overwritten)
+ * @param flags: the event and the mode of the LN driver
+ * @param data: the byte
+ */
+void lnTraceAdd(uint8_t flags, uint8_t data)
+{
+    if (lnTraceFrozen)
+    {
+        return;
+    }
+    lnTraceEntry_t* entry = &lnTraceBuffer[lnTraceHead & (LN_TRACE_SIZE - 1)];
+    // reading TMR0L latches TMR0H (16 bit mode)
+    uint8_t low = TMR0L;
+    entry->time = (uint16_t) ((TMR0H << 8) | low);
+    entry->data = data;
+    entry->flags = flags;
+    lnTraceHead++;
+}
+
+/**
+ * release the trace when a dump is abandoned (in the timer 3 interrupt)
+ */
+void lnTraceTick(void)
+{
+    if (lnTraceFrozen)
+    {
+        if (--lnTraceRelease == 0)
+        {
+            lnTraceFrozen = false;
+        }
+    }
+}
+
+/**
+ * get a chunk of the trace (2 entries, the oldest entries first)
+ * the trace is frozen when chunk 0 is read (a dump starts again) and
+ * released after the last chunk, so the bytes of the dump itself are not
+ * traced, every chunk restarts the release time (LN_TRACE_RELEASE_TICKS)
+ * @param data: the buffer for the chunk (7 bytes): flags of both entries
+ * (entry 1 in bits 0 - 3, entry 2 in bits 4 - 7), then per entry the time
+ * (lsb, msb) and the byte
+ * @param chunk: the chunk (0 - LN_TRACE_CHUNKS - 1)
+ */
+void getLnTraceChunk(uint8_t* data, uint8_t chunk)
+{
+    if (chunk == 0)
+    {
+        lnTraceFrozen = true;
+    }
+    lnTraceRelease = LN_TRACE_RELEASE_TICKS;
+    data[0] = 0;
+    for (uint8_t i = 0; i < 2; i++)
+    {
+        uint8_t index = (uint8_t) (lnTraceHead + (chunk * 2) + i);
+        lnTraceEntry_t* entry = &lnTraceBuffer[index & (LN_TRACE_SIZE - 1)];
+        data[0] |= (uint8_t) ((entry->flags & 0x0f) << (i * 4));
+        data[1 + (i * 3)] = (uint8_t) (entry->time & 0xff);
+        data[2 + (i * 3)] = (uint8_t) (entry->time >> 8);
+        data[3 + (i * 3)] = entry->data;
+    }
+    if (chunk >= (LN_TRACE_CHUNKS - 1))
+    {
+        lnTraceFrozen = false;
+    }
+}
+
+#endif
@@ -0,0 +1,78 @@
+/*
+ * file: trace.h
+ * author: J. van Hooydonk
+ * comments: trace of the LN bytes (optional)
+ *
+ * the trace keeps the last LN_TRACE_SIZE bytes on LN (received, transmitted
+ * and the linebreaks) in a ring buffer, with the time of the free-running
+ * timer 0 (Fosc / 4 / 64, 1 tick = 4us) and the mode of the LN driver
+ * enable it with LN_TRACE (below or on the command line of the compiler),
+ * without LN_TRACE the LN_TRACE_ADD and LN_TRACE_TICK macros are empty
+ *
+ * revision history:
+ *  v1.0 Creation (16/10/2026)
+ *  v1.1 the trace is released when a dump is abandoned (16/10/2026)
+ */
+
+// This is a guard condition so that contents of this file are not included
+// more than once.
+#ifndef TRACE_H
+#define	TRACE_H
+
+#include "config.h"
+
+// #define LN_TRACE
+
+// definitions
+// number of entries of the trace (power of 2), the trace is read in chunks
+// of 2 entries (1 peer transfer per chunk)
+#define LN_TRACE_SIZE 64U
+#define LN_TRACE_CHUNKS (LN_TRACE_SIZE / 2U)
+// flags of an entry: bits 0 - 1 = mode of the LN driver (lnMode), bits 2 - 3
+// = event
+#define LN_TRACE_RX 0x00 // received byte
+#define LN_TRACE_TX 0x04 // transmitted byte
+#define LN_TRACE_LINEBREAK 0x08 // linebreak (data = length in 8us)
+#define LN_TRACE_EMPTY 0x0f // entry not used
+#define LN_TRACE_US_PER_TICK 4U
+// the trace is released when no chunk is read during 1s (in ticks of timer 3
+// = 2.5ms), so a requester that stops early or loses a reply doesn't disable
+// the trace till a reset
+#define LN_TRACE_RELEASE_TICKS 400U
+
+#if (LN_TRACE_SIZE & (LN_TRACE_SIZE - 1)) != 0
+#error "the number of trace entries must be a power of 2"
+#endif
+
+// entry of the trace (1 byte on LN)
+
+typedef struct {
+    uint16_t time; // timer 0 (ticks of 4us)
+    uint8_t data; // the byte
+    uint8_t flags; // event + mode of the LN driver
+} lnTraceEntry_t;
+
+#ifdef LN_TRACE
+// add an entry (in the LN driver, the mode is the actual mode)
+#define LN_TRACE_ADD(event, data) \
+    lnTraceAdd((uint8_t) ((event) | LNCON.LN_MODE), data)
+// time base of the release of the trace (timer 3, every 2.5ms)
+#define LN_TRACE_TICK() lnTraceTick()
+
+// routines
+void lnTraceInit(void);
+void lnTraceAdd(uint8_t, uint8_t);
+void lnTraceTick(void);
+void getLnTraceChunk(uint8_t*, uint8_t);
+
+// variables
+lnTraceEntry_t lnTraceBuffer[LN_TRACE_SIZE];
+uint8_t lnTraceHead; // next entry to write (= oldest entry)
+bool lnTraceFrozen; // the trace is read, no entries are added
+uint16_t lnTraceRelease; // ticks till the trace is released
+#else
+#define LN_TRACE_ADD(event, data)
+#define LN_TRACE_TICK()
+#endif
+
+#endif	/* TRACE_H */